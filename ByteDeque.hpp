@@ -0,0 +1,228 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fefu_laboratory_two {
+
+// Байтовый буфер ввода-вывода из блоков (chunk) фиксированного размера. Каталог блоков - кольцо на std::vector,
+// которое растет только до наибольшего числа одновременно занятых блоков.
+// Данные дописываются в конец и забираются с начала. peek_iovecs отдает занятые участки для writev,
+// prepare_iovecs + commit - свободные участки для readv, так что сокет пишет и читает прямо из буфера без копий.
+// Освободившиеся блоки остаются в запасе, а кольцо не сжимается, поэтому в установившемся режиме память не выделяется.
+class ByteDeque {
+ public:
+  using size_type = std::size_t;
+
+  /// @brief Constructs an empty buffer.
+  /// @param chunk_size size of one chunk in bytes
+  /// @param spare_chunks how many free chunks to keep for reuse
+  explicit ByteDeque(size_type chunk_size = 16384, size_type spare_chunks = 4)
+      : chunk_size(chunk_size ? chunk_size : 1), max_spare(spare_chunks){
+      spare.reserve(max_spare);
+  }
+
+  ByteDeque(const ByteDeque&) = delete;
+  ByteDeque& operator=(const ByteDeque&) = delete;
+
+  ~ByteDeque(){
+      for(size_type i = 0; i < count; i++) delete[] chunk_at(i).data;
+      for(char* data : spare) delete[] data;
+  }
+
+  /// @brief Returns the number of readable bytes.
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if there are no readable bytes.
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Copies n bytes from data to the end of the buffer.
+  void append(const void* data, size_type n){
+      const char* src = static_cast<const char*>(data);
+      while(n > 0){
+          Chunk& chunk = writable_chunk();
+          size_type part = n < chunk_size - chunk.end ? n : chunk_size - chunk.end;
+          std::memcpy(chunk.data + chunk.end, src, part);
+          advance_write(part);
+          src += part;
+          n -= part;
+      }
+  }
+
+  /// @brief Discards the first n readable bytes (or all of them, if there are
+  /// fewer). Fully consumed chunks go back to the spare list.
+  void consume(size_type n){
+      if(n > _size) n = _size;
+      _size -= n;
+      while(n > 0){
+          Chunk& chunk = chunk_at(0);
+          size_type part = n < chunk.end - chunk.begin ? n : chunk.end - chunk.begin;
+          chunk.begin += part;
+          n -= part;
+          if(chunk.begin == chunk.end) release_front();
+      }
+  }
+
+  /// @brief Fills iov with up to max segments covering the readable bytes,
+  /// front to back, ready for writev(). Nothing is consumed.
+  /// @return Number of segments filled.
+  size_type peek_iovecs(struct iovec* iov, size_type max) const{
+      size_type filled = 0;
+      for(size_type i = 0; i < count && filled < max; i++){
+          const Chunk& chunk = chunk_at(i);
+          if(chunk.end == chunk.begin) break;
+          iov[filled].iov_base = chunk.data + chunk.begin;
+          iov[filled].iov_len = chunk.end - chunk.begin;
+          filled++;
+          if(i == write) break;
+      }
+      return filled;
+  }
+
+  /// @brief Makes sure at least want bytes of free space follow the readable
+  /// data and fills iov with up to max segments covering it, ready for
+  /// readv(). Call commit() with the number of bytes actually read.
+  /// @return Number of segments filled.
+  size_type prepare_iovecs(struct iovec* iov, size_type max, size_type want){
+      size_type room = 0;
+      for(size_type i = write; i < count; i++) room += chunk_size - chunk_at(i).end;
+      while(room < want){
+          push_chunk();
+          room += chunk_size;
+      }
+      size_type filled = 0;
+      for(size_type i = write; i < count && filled < max; i++){
+          Chunk& chunk = chunk_at(i);
+          iov[filled].iov_base = chunk.data + chunk.end;
+          iov[filled].iov_len = chunk_size - chunk.end;
+          filled++;
+      }
+      return filled;
+  }
+
+  /// @brief Marks n bytes of the space returned by prepare_iovecs() as
+  /// readable.
+  void commit(size_type n){
+      while(n > 0){
+          Chunk& chunk = chunk_at(write);
+          size_type part = n < chunk_size - chunk.end ? n : chunk_size - chunk.end;
+          advance_write(part);
+          n -= part;
+      }
+  }
+
+  /// @brief Writes as much as possible to fd with one writev() and consumes
+  /// what was written.
+  /// @return Number of bytes written.
+  /// @throw std::system_error if writev fails with anything but EAGAIN/EINTR
+  size_type write_to(int fd, size_type max_iovecs = 64){
+      std::vector<struct iovec> iov(max_iovecs);
+      size_type filled = peek_iovecs(iov.data(), iov.size());
+      if(filled == 0) return 0;
+      ssize_t n = ::writev(fd, iov.data(), static_cast<int>(filled));
+      if(n < 0){
+          if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+          throw std::system_error(errno, std::generic_category(), "ByteDeque: writev");
+      }
+      consume(static_cast<size_type>(n));
+      return static_cast<size_type>(n);
+  }
+
+  /// @brief Reads up to want bytes from fd with one readv() straight into the
+  /// free space at the end of the buffer.
+  /// @return Number of bytes read, 0 at end of file, if nothing is ready or
+  /// if want is 0.
+  /// @throw std::system_error if readv fails with anything but EAGAIN/EINTR
+  size_type read_from(int fd, size_type want, size_type max_iovecs = 64){
+      if(want == 0 || max_iovecs == 0) return 0;
+      std::vector<struct iovec> iov(max_iovecs);
+      size_type filled = prepare_iovecs(iov.data(), iov.size(), want);
+      ssize_t n = ::readv(fd, iov.data(), static_cast<int>(filled));
+      if(n < 0){
+          if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+          throw std::system_error(errno, std::generic_category(), "ByteDeque: readv");
+      }
+      commit(static_cast<size_type>(n));
+      return static_cast<size_type>(n);
+  }
+
+ private:
+  //Занятые байты блока - [begin, end), свободные - [end, chunk_size).
+  struct Chunk {
+      char* data = nullptr;
+      size_type begin = 0;
+      size_type end = 0;
+  };
+
+  //i-й от начала занятый блок кольца.
+  Chunk& chunk_at(size_type i) noexcept{
+      return ring[(head + i) % ring.size()];
+  }
+
+  const Chunk& chunk_at(size_type i) const noexcept{
+      return ring[(head + i) % ring.size()];
+  }
+
+  //Добавляет в конец пустой блок из запаса или новый. Кольцо удваивается, только когда заняты все его места.
+  void push_chunk(){
+      if(count == ring.size()){
+          std::vector<Chunk> bigger(ring.empty() ? 4 : ring.size() * 2);
+          for(size_type i = 0; i < count; i++) bigger[i] = chunk_at(i);
+          ring.swap(bigger);
+          head = 0;
+      }
+      Chunk chunk;
+      if(spare.empty()){
+          chunk.data = new char[chunk_size];
+      }
+      else{
+          chunk.data = spare.back();
+          spare.pop_back();
+      }
+      ring[(head + count) % ring.size()] = chunk;
+      count++;
+  }
+
+  //Блок, куда пойдет следующая запись. Все блоки после write пустые, до него - заполнены.
+  Chunk& writable_chunk(){
+      if(write == count) push_chunk();
+      return chunk_at(write);
+  }
+
+  void advance_write(size_type n){
+      Chunk& chunk = chunk_at(write);
+      chunk.end += n;
+      _size += n;
+      if(chunk.end == chunk_size) write++;
+  }
+
+  void release_front(){
+      Chunk& chunk = chunk_at(0);
+      if(spare.size() < max_spare) spare.push_back(chunk.data);
+      else delete[] chunk.data;
+      chunk = Chunk();
+      head = (head + 1) % ring.size();
+      count--;
+      if(write > 0) write--;
+  }
+
+  std::vector<Chunk> ring;
+  size_type head = 0;  //Место первого занятого блока в ring.
+  size_type count = 0; //Число занятых блоков.
+  size_type write = 0; //Номер от начала блока, куда пойдет следующая запись; count - такого блока еще нет.
+  std::vector<char*> spare;
+  size_type _size = 0;
+  size_type chunk_size;
+  size_type max_spare;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,306 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек целых чисел со сжатием холодных блоков. Элементы лежат в блоках по block_elements штук, каталог
+// блоков - обычный Deque. hot_blocks блоков у каждого конца хранятся как есть, а блоки, ушедшие в середину,
+// сжимаются: первое значение, затем разности соседних элементов в zigzag-кодировке, упакованные
+// одинаковым числом бит. Для монотонных временных меток и счетчиков это несколько бит на элемент.
+// Сжатый блок распаковывается целиком при чтении из него, последний распакованный блок кэшируется.
+// Кэш меняется и в const-методах front, back, operator[] и at, поэтому, в отличие от стандартных контейнеров,
+// даже одновременное чтение из разных потоков требует внешней синхронизации; for_each кэш не трогает.
+template <typename T>
+class CompressedDeque {
+  static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "CompressedDeque needs an integral T");
+  static_assert(sizeof(T) <= sizeof(std::uint64_t), "CompressedDeque supports integers up to 64 bits");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  /// @brief Constructs an empty deque.
+  /// @param block_elements number of elements in one block
+  /// @param hot_blocks how many blocks at each end stay uncompressed
+  explicit CompressedDeque(size_type block_elements = 1024, size_type hot_blocks = 2)
+      : block_elements(block_elements ? block_elements : 1), hot_blocks(hot_blocks ? hot_blocks : 1) {}
+
+  CompressedDeque(const CompressedDeque&) = delete;
+  CompressedDeque& operator=(const CompressedDeque&) = delete;
+
+  ~CompressedDeque(){
+      for(Node<Segment*>* cur = segments.first; cur != nullptr; cur = cur->next) delete cur->value;
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Number of blocks currently stored compressed.
+  size_type compressed_blocks() const noexcept{
+      return compressed;
+  }
+
+  /// @brief Approximate number of bytes used by element storage, the block
+  /// directory and the decode cache.
+  size_type memory_usage() const noexcept{
+      size_type bytes = cache.capacity() * sizeof(value_type);
+      for(Node<Segment*>* cur = segments.first; cur != nullptr; cur = cur->next){
+          const Segment* segment = cur->value;
+          bytes += sizeof(Node<Segment*>) + sizeof(Segment);
+          if(segment->items) bytes += block_elements * sizeof(value_type);
+          else bytes += segment->packed.capacity() * sizeof(std::uint64_t);
+      }
+      return bytes;
+  }
+
+  /// @brief Calling front on an empty container is undefined. Not safe to
+  /// call concurrently with any other access, see operator[].
+  value_type front() const{
+      return get(segments.front(), 0);
+  }
+
+  /// @brief Calling back on an empty container is undefined. Not safe to
+  /// call concurrently with any other access, see operator[].
+  value_type back() const{
+      const Segment* segment = segments.back();
+      return get(segment, segment->count() - 1);
+  }
+
+  /// @brief Returns the element at pos, decompressing its block if needed.
+  /// Finds the block by walking the directory from the nearer end. No bounds
+  /// checking is performed. The decoded block is kept in a shared cache, so
+  /// concurrent calls, even const ones, need external synchronization.
+  value_type operator[](size_type pos) const{
+      if(pos < _size / 2){
+          for(Node<Segment*>* cur = segments.first;; cur = cur->next){
+              if(pos < cur->value->count()) return get(cur->value, pos);
+              pos -= cur->value->count();
+          }
+      }
+      size_type rest = _size - pos;
+      for(Node<Segment*>* cur = segments.last;; cur = cur->previous){
+          if(rest <= cur->value->count()) return get(cur->value, cur->value->count() - rest);
+          rest -= cur->value->count();
+      }
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  value_type at(size_type pos) const{
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Calls f(value) for every element from front to back, decoding
+  /// each compressed block once into a local buffer. Does not touch the
+  /// decode cache, so concurrent for_each calls are safe.
+  template <class F>
+  void for_each(F f) const{
+      std::vector<value_type> decoded;
+      for(Node<Segment*>* cur = segments.first; cur != nullptr; cur = cur->next){
+          const Segment* segment = cur->value;
+          if(segment->items){
+              for(size_type i = segment->lo; i < segment->hi; i++) f(segment->items[i]);
+          }
+          else{
+              decode(*segment, decoded);
+              for(const value_type& value : decoded) f(value);
+          }
+      }
+  }
+
+  /// @brief Appends value to the end. May compress the block that leaves the
+  /// hot tail.
+  void push_back(const T& value){
+      if(segments.empty() || !segments.back()->items || segments.back()->hi == block_elements){
+          segments.push_back(new_segment(0));
+          cool(segments.last, false);
+      }
+      Segment* segment = segments.back();
+      segment->items[segment->hi++] = value;
+      _size++;
+  }
+
+  /// @brief Prepends value to the beginning. May compress the block that
+  /// leaves the hot head.
+  void push_front(const T& value){
+      if(segments.empty() || !segments.front()->items || segments.front()->lo == 0){
+          segments.push_front(new_segment(block_elements));
+          cool(segments.first, true);
+      }
+      Segment* segment = segments.front();
+      segment->items[--segment->lo] = value;
+      _size++;
+  }
+
+  /// @brief Removes the first element, decompressing the next block when the
+  /// front reaches it. Calling pop_front on an empty container is undefined.
+  void pop_front(){
+      Segment* segment = segments.front();
+      make_hot(segment);
+      segment->lo++;
+      _size--;
+      if(segment->lo == segment->hi){
+          drop(segment);
+          segments.pop_front();
+      }
+  }
+
+  /// @brief Removes the last element, decompressing the previous block when
+  /// the back reaches it. Calling pop_back on an empty container is undefined.
+  void pop_back(){
+      Segment* segment = segments.back();
+      make_hot(segment);
+      segment->hi--;
+      _size--;
+      if(segment->lo == segment->hi){
+          drop(segment);
+          segments.pop_back();
+      }
+  }
+
+ private:
+  using unsigned_type = typename std::make_unsigned<T>::type;
+
+  //Блок либо распакован (items, занятые позиции [lo, hi)), либо сжат: first - первое значение,
+  //packed - остальные length - 1 разностей по width бит каждая.
+  struct Segment {
+      std::unique_ptr<value_type[]> items;
+      size_type lo = 0;
+      size_type hi = 0;
+      std::vector<std::uint64_t> packed;
+      std::uint64_t first = 0;
+      size_type length = 0;
+      unsigned width = 0;
+
+      size_type count() const noexcept{
+          return items ? hi - lo : length;
+      }
+  };
+
+  Segment* new_segment(size_type start){
+      Segment* segment = new Segment;
+      segment->items.reset(new value_type[block_elements]);
+      segment->lo = start;
+      segment->hi = start;
+      return segment;
+  }
+
+  value_type get(const Segment* segment, size_type pos) const{
+      if(segment->items) return segment->items[segment->lo + pos];
+      if(cached != segment){
+          decode(*segment, cache);
+          cached = segment;
+      }
+      return cache[pos];
+  }
+
+  //После нового блока у конца блок на расстоянии hot_blocks от этого конца покидает горячую зону.
+  //Сжимается, только если он не попадает и в горячую зону противоположного конца.
+  void cool(Node<Segment*>* cur, bool forward){
+      size_type distance = 0;
+      for(; cur != nullptr && distance < hot_blocks; distance++) cur = forward ? cur->next : cur->previous;
+      if(cur == nullptr || segments.size() < 2 * hot_blocks + 1) return;
+      if(cur->value->items && cur->value->hi > cur->value->lo) compress(cur->value);
+  }
+
+  static std::uint64_t zigzag(std::uint64_t delta) noexcept{
+      return (delta << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(delta) >> 63);
+  }
+
+  static std::uint64_t unzigzag(std::uint64_t code) noexcept{
+      return (code >> 1) ^ (~(code & 1) + 1);
+  }
+
+  //Значения переводятся в uint64 с заворотом, так что разности корректны и для знаковых, и для беззнаковых T.
+  static std::uint64_t widen(value_type value) noexcept{
+      return static_cast<std::uint64_t>(static_cast<unsigned_type>(value));
+  }
+
+  static value_type narrow(std::uint64_t value) noexcept{
+      return static_cast<value_type>(static_cast<unsigned_type>(value));
+  }
+
+  void compress(Segment* segment){
+      const value_type* items = segment->items.get() + segment->lo;
+      size_type n = segment->hi - segment->lo;
+      std::uint64_t widest = 0;
+      for(size_type i = 1; i < n; i++) widest |= zigzag(widen(items[i]) - widen(items[i - 1]));
+      unsigned width = 0;
+      while(width < 64 && (widest >> width) != 0) width++;
+      std::vector<std::uint64_t> packed(((n - 1) * width + 63) / 64);
+      size_type bit = 0;
+      for(size_type i = 1; i < n && width != 0; i++, bit += width){
+          std::uint64_t code = zigzag(widen(items[i]) - widen(items[i - 1]));
+          packed[bit / 64] |= code << (bit % 64);
+          if(bit % 64 + width > 64) packed[bit / 64 + 1] |= code >> (64 - bit % 64);
+      }
+      segment->first = widen(items[0]);
+      segment->length = n;
+      segment->width = width;
+      segment->packed.swap(packed);
+      segment->items.reset();
+      compressed++;
+  }
+
+  static void decode(const Segment& segment, std::vector<value_type>& out){
+      out.resize(segment.length);
+      std::uint64_t value = segment.first;
+      std::uint64_t mask = segment.width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << segment.width) - 1;
+      out[0] = narrow(value);
+      size_type bit = 0;
+      for(size_type i = 1; i < segment.length; i++, bit += segment.width){
+          std::uint64_t code = 0;
+          if(segment.width != 0){
+              code = segment.packed[bit / 64] >> (bit % 64);
+              if(bit % 64 + segment.width > 64) code |= segment.packed[bit / 64 + 1] << (64 - bit % 64);
+              code &= mask;
+          }
+          value += unzigzag(code);
+          out[i] = narrow(value);
+      }
+  }
+
+  //Сжатый блок, до которого дошли pop, снова хранится распакованным. Если к сжатому блоку у конца
+  //приходит push, рядом просто заводится новый блок.
+  void make_hot(Segment* segment){
+      if(segment->items) return;
+      std::vector<value_type> decoded;
+      decode(*segment, decoded);
+      segment->items.reset(new value_type[block_elements]);
+      segment->lo = 0;
+      segment->hi = 0;
+      for(const value_type& value : decoded) segment->items[segment->hi++] = value;
+      segment->packed = std::vector<std::uint64_t>();
+      compressed--;
+      if(cached == segment) cached = nullptr;
+  }
+
+  void drop(Segment* segment){
+      if(cached == segment) cached = nullptr;
+      delete segment;
+  }
+
+  Deque<Segment*> segments;
+  mutable const Segment* cached = nullptr; //Блок, распакованный в cache для operator[].
+  mutable std::vector<value_type> cache;
+  size_type _size = 0;
+  size_type compressed = 0;
+  size_type block_elements;
+  size_type hot_blocks;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,307 @@
+#pragma once
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек с копированием при записи (copy-on-write). Элементы лежат в сегментах - обычных Deque не длиннее
+// segment_capacity, сегменты и их каталог разделяются между копиями через счетчики ссылок shared_ptr.
+// Копия стоит O(1), сегмент дублируется только тогда, когда в него пишет одна из сторон.
+// Все сегменты, кроме первого и последнего, всегда полные, поэтому сегмент по индексу находится за O(1).
+template <typename T, typename Allocator = Allocator<Node<T>>>
+class CowDeque {
+ public:
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using segment_type = Deque<T, Allocator>;
+
+ private:
+  //Каталог сегментов, занята часть [head, segments.size()). Место перед head оставлено для push_front.
+  struct Directory {
+      std::vector<std::shared_ptr<segment_type>> segments;
+      size_type head = 0;
+      size_type size = 0;
+  };
+
+ public:
+  //Итератор только для чтения, идет по узлам сегмента и переходит к следующему сегменту.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    reference operator*() const{
+        return cur->value;
+    }
+
+    pointer operator->() const{
+        return &cur->value;
+    }
+
+    const_iterator& operator++(){
+        cur = cur->next;
+        while(cur == nullptr && ++segment < directory->segments.size()){
+            cur = directory->segments[segment]->first;
+        }
+        return *this;
+    }
+
+    const_iterator operator++(int){
+        const_iterator temp(*this);
+        operator++();
+        return temp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b){
+        return a.cur == b.cur;
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b){
+        return a.cur != b.cur;
+    }
+
+   private:
+    friend class CowDeque;
+    const Directory* directory = nullptr;
+    size_type segment = 0;
+    Node<T>* cur = nullptr;
+  };
+
+  /// @brief Constructs an empty container.
+  /// @param segment_capacity maximum number of elements in one shared segment
+  explicit CowDeque(size_type segment_capacity = 64)
+      : directory(std::make_shared<Directory>()), segment_capacity(segment_capacity ? segment_capacity : 1) {}
+
+  /// @brief Copy constructor. The copy shares all storage with other.
+  /// Complexity: constant.
+  CowDeque(const CowDeque& other) = default;
+
+  /// @brief Copy assignment operator. *this shares all storage with other.
+  /// Complexity: constant.
+  CowDeque& operator=(const CowDeque& other) = default;
+
+  /// @brief Returns a copy sharing all storage with *this. Same to the copy
+  /// constructor, spelled out for call sites that take snapshots.
+  CowDeque snapshot() const{
+      return *this;
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return directory->size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return directory->size == 0;
+  }
+
+  /// @brief Returns a const reference to the element at pos, without
+  /// unsharing. No bounds checking is performed.
+  /// Complexity: O(segment_capacity).
+  const_reference operator[](size_type pos) const{
+      size_type segment, offset;
+      locate(pos, segment, offset);
+      return node_at(*directory->segments[segment], offset)->value;
+  }
+
+  /// @brief Returns a reference to the element at pos. The segment holding it
+  /// is duplicated first if it is shared. No bounds checking is performed.
+  /// Complexity: O(segment_capacity), plus the copy of the directory and the
+  /// segment if they are shared.
+  reference operator[](size_type pos){
+      size_type segment, offset;
+      locate(pos, segment, offset);
+      return node_at(writable_segment(segment), offset)->value;
+  }
+
+  /// @brief Same to operator[] const, with bounds checking.
+  /// @throw std::out_of_range
+  const_reference at(size_type pos) const{
+      if(pos >= size()) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  reference at(size_type pos){
+      if(pos >= size()) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Returns a const reference to the first element. Calling front on
+  /// an empty container is undefined.
+  const_reference front() const{
+      return directory->segments[directory->head]->front();
+  }
+
+  /// @brief Returns a const reference to the last element. Calling back on
+  /// an empty container is undefined.
+  const_reference back() const{
+      return directory->segments.back()->back();
+  }
+
+  /// @brief Returns an iterator to the first element.
+  const_iterator begin() const noexcept{
+      const_iterator a;
+      a.directory = directory.get();
+      a.segment = directory->head;
+      if(!empty()) a.cur = directory->segments[a.segment]->first;
+      return a;
+  }
+
+  /// @brief Returns an iterator to the element following the last element.
+  const_iterator end() const noexcept{
+      const_iterator a;
+      a.directory = directory.get();
+      a.segment = directory->segments.size();
+      return a;
+  }
+
+  /// @brief Appends value to the end, duplicating the back segment if shared.
+  void push_back(const T& value){
+      Directory& dir = writable_directory();
+      if(dir.segments.size() == dir.head || dir.segments.back()->size() >= segment_capacity){
+          dir.segments.push_back(std::make_shared<segment_type>());
+      }
+      writable_segment(dir.segments.size() - 1).push_back(value);
+      dir.size++;
+  }
+
+  /// @brief Prepends value to the beginning, duplicating the front segment if
+  /// shared.
+  void push_front(const T& value){
+      Directory& dir = writable_directory();
+      if(dir.segments.size() == dir.head || dir.segments[dir.head]->size() >= segment_capacity){
+          if(dir.head == 0) make_room_in_front(dir);
+          dir.segments[--dir.head] = std::make_shared<segment_type>();
+      }
+      writable_segment(dir.head).push_front(value);
+      dir.size++;
+  }
+
+  /// @brief Removes the last element. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back(){
+      Directory& dir = writable_directory();
+      size_type segment = dir.segments.size() - 1;
+      if(dir.segments[segment]->size() == 1){
+          dir.segments.pop_back();
+          if(dir.segments.size() == dir.head) reset(dir);
+      }
+      else{
+          writable_segment(segment).pop_back();
+      }
+      dir.size--;
+  }
+
+  /// @brief Removes the first element. Calling pop_front on an empty container
+  /// is undefined.
+  void pop_front(){
+      Directory& dir = writable_directory();
+      if(dir.segments[dir.head]->size() == 1){
+          dir.segments[dir.head++].reset();
+          if(dir.segments.size() == dir.head) reset(dir);
+          else if(dir.head > dir.segments.size() / 2){
+              dir.segments.erase(dir.segments.begin(), dir.segments.begin() + dir.head);
+              dir.head = 0;
+          }
+      }
+      else{
+          writable_segment(dir.head).pop_front();
+      }
+      dir.size--;
+  }
+
+  /// @brief Erases all elements. Storage shared with other copies is kept
+  /// alive by them.
+  void clear(){
+      directory = std::make_shared<Directory>();
+  }
+
+  /// @brief Returns the number of segments that are shared with at least one
+  /// other copy, that is, the segments that have not diverged yet.
+  size_type shared_segments() const noexcept{
+      size_type shared = 0;
+      for(size_type i = directory->head; i < directory->segments.size(); i++){
+          if(directory->segments[i].use_count() > 1 || directory.use_count() > 1) shared++;
+      }
+      return shared;
+  }
+
+  /// @brief Returns the number of segments.
+  size_type segment_count() const noexcept{
+      return directory->segments.size() - directory->head;
+  }
+
+ private:
+  //Каталог, в который можно писать: если его разделяет кто-то еще, копируем (копируются только указатели на сегменты).
+  Directory& writable_directory(){
+      if(directory.use_count() > 1) directory = std::make_shared<Directory>(*directory);
+      return *directory;
+  }
+
+  //Сегмент, в который можно писать: сначала отделяем каталог, потом сам сегмент, если он общий.
+  segment_type& writable_segment(size_type segment){
+      Directory& dir = writable_directory();
+      if(dir.segments[segment].use_count() > 1){
+          dir.segments[segment] = std::make_shared<segment_type>(*dir.segments[segment]);
+      }
+      return *dir.segments[segment];
+  }
+
+  //Находит сегмент и смещение в нем для позиции pos.
+  void locate(size_type pos, size_type& segment, size_type& offset) const{
+      size_type front_size = directory->segments[directory->head]->size();
+      if(pos < front_size){
+          segment = directory->head;
+          offset = pos;
+          return;
+      }
+      pos -= front_size;
+      segment = directory->head + 1 + pos / segment_capacity;
+      offset = pos % segment_capacity;
+  }
+
+  //Узел с номером offset в сегменте, идем с ближайшего конца.
+  static Node<T>* node_at(const segment_type& segment, size_type offset){
+      Node<T>* cur;
+      if(offset <= segment.size() / 2){
+          cur = segment.first;
+          for(size_type i = 0; i < offset; i++) cur = cur->next;
+      }
+      else{
+          cur = segment.last;
+          for(size_type i = segment.size() - 1; i > offset; i--) cur = cur->previous;
+      }
+      return cur;
+  }
+
+  //Сдвигаем занятые сегменты вправо, чтобы перед head появилось место. Амортизированно O(1) на push_front.
+  static void make_room_in_front(Directory& dir){
+      size_type used = dir.segments.size() - dir.head;
+      size_type room = used > 4 ? used : 4;
+      std::vector<std::shared_ptr<segment_type>> segments(room + used);
+      std::move(dir.segments.begin() + dir.head, dir.segments.end(), segments.begin() + room);
+      dir.segments.swap(segments);
+      dir.head = room;
+  }
+
+  static void reset(Directory& dir){
+      dir.segments.clear();
+      dir.head = 0;
+  }
+
+  std::shared_ptr<Directory> directory;
+  size_type segment_capacity;
+};
+
+}  // namespace fefu_laboratory_two
@@ -4,6 +4,16 @@
 #include <vector>
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <ratio>
 
 namespace fefu_laboratory_two {
 template <typename T>
@@ -32,8 +42,10 @@ class Allocator {
   ~Allocator() = default;
 
   // Возвращается указатель на выделенное место в памяти под n элементов * на размер типа.
+  // Если sizeof(T) * n не помещается в size_t, выделять нечего: исключение, а не блок меньшего размера.
   pointer allocate(size_type n)
   {
+      if(n > std::numeric_limits<size_type>::max() / sizeof(T)) throw std::bad_array_new_length();
       return static_cast<pointer>(operator new(sizeof(T) * n ));
   }
 
@@ -49,11 +61,110 @@ class Allocator {
 template <typename T>
 class Node {
 public:
-    T value = NULL;
+    T value = T();
     Node* next = nullptr;
     Node* previous = nullptr;
 };
 
+// Блоки (chunk), в которые compact() и load() размещают узлы, записанные в том деке, который их использует.
+// splice, split_at и swap передают узлы между деками, поэтому дек, получающий узлы, получает и записи блоков
+// другого дека (share), а одна запись блока может быть в нескольких деках. live - сколько узлов блока живо,
+// узлы блока освобождаются, когда он обнуляется; refs - в скольких деках блок записан, сама запись удаляется,
+// когда обнуляется он. Дек без блоков (не вызывавший compact и load) освобождает узлы без поиска.
+template <typename NodeType, typename Allocator>
+class Node_chunks {
+ public:
+  struct Chunk {
+      NodeType* nodes;
+      std::size_t capacity;
+      std::atomic<std::size_t> live;
+      std::atomic<std::size_t> refs;
+  };
+
+  Node_chunks() = default;
+  Node_chunks(const Node_chunks&) = delete;
+  Node_chunks& operator=(const Node_chunks&) = delete;
+
+  ~Node_chunks(){
+      for(Chunk* chunk : chunks) unref(chunk);
+  }
+
+  bool empty() const noexcept{
+      return chunks.empty();
+  }
+
+  // Выделяет блок на capacity узлов. Блок сразу занят одной ссылкой, которую держит тот, кто его заполняет.
+  NodeType* allocate(std::size_t capacity, Allocator& alloc){
+      if(capacity > std::numeric_limits<std::size_t>::max() / sizeof(NodeType)) throw std::bad_array_new_length();
+      NodeType* nodes = alloc.allocate(capacity);
+      Chunk* chunk = new Chunk{nodes, capacity, {1}, {1}};
+      chunks.insert(std::upper_bound(chunks.begin(), chunks.end(), nodes, address_less), chunk);
+      return nodes;
+  }
+
+  // В блоке, где лежит node, размещено еще count узлов, увеличиваем счетчик блока.
+  void retain(NodeType* node, std::size_t count = 1){
+      (*find(node))->live += count;
+  }
+
+  // Возвращает false, если node не из блока и его нужно освободить обычным deallocate.
+  bool release(NodeType* node, Allocator& alloc){
+      if(chunks.empty()) return false;
+      typename std::vector<Chunk*>::iterator it = find(node);
+      if(it == chunks.end()) return false;
+      Chunk* chunk = *it;
+      if(--chunk->live == 0){
+          alloc.deallocate(chunk->nodes);
+          chunks.erase(it);
+          unref(chunk);
+      }
+      return true;
+  }
+
+  // Записывает в этот дек живые блоки other: узлы из них могли перейти сюда.
+  void share(const Node_chunks& other){
+      for(Chunk* chunk : other.chunks){
+          if(chunk->live == 0) continue;
+          typename std::vector<Chunk*>::iterator at = std::upper_bound(chunks.begin(), chunks.end(), chunk->nodes, address_less);
+          if(at != chunks.begin() && *(at - 1) == chunk) continue;
+          chunk->refs++;
+          chunks.insert(at, chunk);
+      }
+  }
+
+  void swap(Node_chunks& other) noexcept{
+      chunks.swap(other.chunks);
+  }
+
+ private:
+  static bool address_less(const NodeType* node, const Chunk* chunk){
+      return std::less<const NodeType*>()(node, chunk->nodes);
+  }
+
+  static void unref(Chunk* chunk){
+      if(--chunk->refs == 0) delete chunk;
+  }
+
+  // Ищет живой блок, в котором лежит node. Блоки, освобожденные через другой дек (live == 0), попутно выбрасываются:
+  // их память могла уже достаться новым узлам. Живые блоки не пересекаются, поэтому достаточно ближайшего живого слева.
+  typename std::vector<Chunk*>::iterator find(const NodeType* node){
+      typename std::vector<Chunk*>::iterator it = std::upper_bound(chunks.begin(), chunks.end(), node, address_less);
+      while(it != chunks.begin()){
+          --it;
+          if((*it)->live == 0){
+              unref(*it);
+              it = chunks.erase(it);
+              continue;
+          }
+          if(std::less<const NodeType*>()(node, (*it)->nodes + (*it)->capacity)) return it;
+          return chunks.end();
+      }
+      return chunks.end();
+  }
+
+  std::vector<Chunk*> chunks; //Упорядочены по адресу.
+};
+
 template <typename ValueType>
 class Deque_iterator {
  public:
@@ -63,6 +174,8 @@ class Deque_iterator {
   using pointer = ValueType*;
   using reference = ValueType&;
   Node<value_type> *cur;
+  //Указатель на поле last дека, чтобы --end() (cur == nullptr) попадал на последний элемент.
+  Node<value_type>* const* tail = nullptr;
 
   // Конструктор по умолчанию не принимает аргументов и устанавливает все переменные класса в их значения по умолчанию.
   Deque_iterator() = default;
@@ -75,12 +188,14 @@ class Deque_iterator {
   // Конструктор копирования, который копирует указатель на текущий элемент из другого итератора
   Deque_iterator(const Deque_iterator& other) noexcept{
       cur = other.cur;
+      tail = other.tail;
   }
 
   // Оператор присваивания, который присваивает указатель на текущий элемент из другого итератора.
   Deque_iterator& operator=(const Deque_iterator& a)
   {
       cur = a.cur;
+      tail = a.tail;
       return *this;
   }
 
@@ -111,7 +226,7 @@ class Deque_iterator {
   }
 
   pointer operator->() const{
-      return *cur -> value;
+      return &cur->value;
   }
 
   // Операторы, которые перемещают текущий элемент на следующий
@@ -129,10 +244,10 @@ class Deque_iterator {
   }
 
 
-  //Смещаем указатель на прошлый элемент и return
+  //Смещаем указатель на прошлый элемент и return, из end() переходим на последний элемент.
   Deque_iterator& operator--()
   {
-      cur = cur->previous;
+      cur = cur == nullptr ? *tail : cur->previous;
       return *this;
   }
 
@@ -216,15 +331,24 @@ public:
     using pointer = ValueType*;
     using reference = ValueType&;
     Node<value_type> *cur;
+    Node<value_type>* const* tail = nullptr;
     Deque_const_iterator() = default;
 
     Deque_const_iterator(const Deque_const_iterator& other) noexcept{
         cur = other.cur;
+        tail = other.tail;
+    }
+
+    //Неявное преобразование из обычного итератора, чтобы begin()/end() неконстантного дека можно было передавать в insert/splice.
+    Deque_const_iterator(const Deque_iterator<ValueType>& other) noexcept{
+        cur = other.cur;
+        tail = other.tail;
     }
 
     Deque_const_iterator& operator=(const Deque_const_iterator& a)
     {
         cur = a.cur;
+        tail = a.tail;
         return *this;
     }
 
@@ -253,7 +377,7 @@ public:
     }
     pointer operator->() const
     {
-        return *cur ->value;
+        return &cur->value;
     }
 
     Deque_const_iterator& operator++(){
@@ -269,12 +393,12 @@ public:
 
     Deque_const_iterator& operator--()
     {
-        cur = cur->previous;
+        cur = cur == nullptr ? *tail : cur->previous;
         return *this;
     }
     Deque_const_iterator operator--(int)
     {
-        Deque_iterator<ValueType> temp(*this);
+        Deque_const_iterator<ValueType> temp(*this);
         operator--();
         return temp;
     }
@@ -378,12 +502,16 @@ class Deque_reverse_iterator {
   iterator_type base() const {return _it;}
 
 
-  //Возвращаем значение элемента, на который указывает основной итератор.
-  reference operator*() const {return *base();}
+  //Обратный итератор указывает на элемент перед основным итератором, поэтому rbegin() строится из end().
+  reference operator*() const {
+      iterator_type it = _it;
+      --it;
+      return *it;
+  }
 
 
    //Возвращает указатель на текущий элемент.
-  pointer operator->() const {return base();}
+  pointer operator->() const {return &operator*();}
 
 
   // Возвращает ссылку на элементн находящийся на n от текущей позиции.
@@ -495,11 +623,38 @@ class Deque_reverse_iterator {
 };
 
 
-template <typename T, typename Allocator = Allocator<Node<T>>>
+// Настройки Deque, выбираемые при компиляции. Вместо Deque_policy можно передать свою структуру с теми же членами.
+// ChunkNodes - сколько узлов в блоке, который выделяет compact(max_nodes); 0 - выбрать по sizeof узла (блок около 16 КБ).
+// ChunkGrowth - во сколько раз (std::ratio) каждый следующий блок одного прохода compact больше предыдущего.
+// CheckedIndex - operator[] проверяет индекс так же, как at(). Statistics - дек считает выделения узлов и блоков.
+// Выключенные возможности отсекаются if constexpr и не добавляют ветвлений в горячие пути.
+template <std::size_t ChunkNodes = 0, class ChunkGrowth = std::ratio<1>, bool CheckedIndex = false, bool Statistics = false>
+struct Deque_policy {
+  static constexpr std::size_t chunk_nodes = ChunkNodes;
+  using chunk_growth = ChunkGrowth;
+  static constexpr bool checked_index = CheckedIndex;
+  static constexpr bool statistics = Statistics;
+};
+
+// Счетчики дека с включенной политикой Statistics.
+struct Deque_statistics {
+  std::size_t node_allocations = 0;
+  std::size_t node_deallocations = 0; //Узлы, удаленные из дека; перенос узла compact сюда не входит.
+  std::size_t chunk_allocations = 0; //Блоки compact() и load().
+  std::size_t nodes_relocated = 0;
+};
+
+struct Deque_no_statistics {};
+
+template <typename T, typename Allocator = Allocator<Node<T>>, typename Policy = Deque_policy<>>
 class Deque {
+  static_assert(std::ratio_greater_equal<typename Policy::chunk_growth, std::ratio<1>>::value,
+                "Deque_policy: chunk growth factor must be at least 1");
+
  public:
   using value_type = T;
   using allocator_type = Allocator;
+  using policy_type = Policy;
   using size_type = std::size_t;
   using difference_type = std::ptrdiff_t;
   using reference = value_type&;
@@ -514,7 +669,22 @@ class Deque {
   Allocator alloc;
   Node<value_type>* first = nullptr;
   Node<value_type>* last = nullptr;
-  value_type _size = 0;
+  size_type _size = 0;
+
+  //Состояние инкрементального compact(max_nodes), переходит вместе с узлами при swap.
+  struct Compaction_state {
+      Node<value_type>* cursor = nullptr; //Следующий узел прохода, nullptr - проход не начат.
+      Node<value_type>* chunk = nullptr; //Блок, который сейчас заполняется.
+      Node<value_type>* slot = nullptr;
+      Node<value_type>* slot_end = nullptr;
+      size_type chunk_capacity = 0; //Размер последнего блока прохода, от него растет следующий.
+  };
+  Compaction_state compaction;
+  size_type churn = 0; //Сколько узлов выделено и освобождено с последнего завершенного прохода.
+  double compaction_threshold = 0;
+  size_type compaction_step = 0;
+  //Без политики Statistics - пустая структура, счетчики не обновляются.
+  std::conditional_t<Policy::statistics, Deque_statistics, Deque_no_statistics> stats;
 
 
   /// @brief Default constructor. Constructs an empty container with a
@@ -524,12 +694,10 @@ class Deque {
   /// @brief Constructs an empty container with the given allocator
   /// @param alloc allocator to use for all memory allocations of this container
 
-  //Конструктор с аллокатором, выделяется память под 1 Node. Указатели стоят на текущей Ноде.
+  //Конструктор с аллокатором, дек пустой, узлы будут выделяться через alloc.
   explicit Deque(const Allocator& alloc)
   {
-     Node<value_type> *node = alloc.allocate(1);
-     first = node;
-     last = node;
+     this->alloc = alloc;
   }
 
   /// @brief Constructs the container with count copies of elements with value
@@ -541,8 +709,8 @@ class Deque {
   //Конструктор, создает дек с count элементами, каждый из которых инициализирован value
   Deque(size_type count, const T& value, const Allocator& alloc = Allocator())
   {
+      this->alloc = alloc;
       for(size_type i = 0; i < count; i++){
-          Node<value_type> *node = alloc.allocate(1);
           push_back(value);
       }
   }
@@ -578,25 +746,13 @@ class Deque {
   /// contents of other.
   /// @param other another container to be used as source to initialize the
   /// elements of the container with
-  //Конструктор копирования, пробегаемся пр всем элементам контейнера other. На каждой итерации выделяется память для нового узла Node
-  //с помощью allocate() из аллокатора связанного с other. Затем значение элемента i контейнера other копируется в значение поля value нового узла Node
-  //Если Other пустой то first и last указывают на новый узел Node, иначе новый узел добавляется в конец контейнера.
-  //В конце устанавливается размер нового контейнера _size = other.size()
+  //Конструктор копирования, идем по узлам other от first к last и добавляем копию каждого значения в конец, O(n).
   Deque(const Deque& other)
   {
-      for(value_type i = 0; i < other.size(); i++){
-          Node<value_type> *node = other.get_allocator().allocate(1);
-          node->value = other[i];
-          if(empty()){
-              this->first = node;
-              this->last = node;
-          }
-          else{
-              last -> next = node;
-              last = node;
-          }
+      alloc = other.alloc;
+      for(Node<value_type>* cur = other.first; cur != nullptr; cur = cur->next){
+          push_back(cur->value);
       }
-      _size = other.size();
   }
 
   /// @brief Constructs the container with the copy of the contents of other,
@@ -606,26 +762,13 @@ class Deque {
   /// @param alloc allocator to use for all memory allocations of this container
 
   //Конструктор копирования, который является копией другого объекта other. alloc для выделения памяти для каждого узла.
-  //Для каждого i в other выделяется память для нового узла, устанавливается значение other[i]
-  //Если новый дек пустой,, то first и last указывают только на созданный узел
-  //Иначе
+  //Идем по узлам other и добавляем копию каждого значения в конец, O(n).
   Deque(const Deque& other, const Allocator& alloc)
   {
-      for(value_type i = 0; i < other.size();i++){
-          Node<value_type> *node = alloc.allocate(1);
-          node->value = other[i];
-          if(empty()){
-              first = node;
-              last = node;
-          }
-          else{
-              node->previous = last; //предыдущий элемент для текущего это last
-              last -> next = node; // предыдущий указывает на новый
-              last = node; // last становится node
-              first->previous = last; //прошлый для first указывает на last элемент
-          }
+      this->alloc = alloc;
+      for(Node<value_type>* cur = other.first; cur != nullptr; cur = cur->next){
+          push_back(cur->value);
       }
-      _size = other.size();
   }
 
   /**
@@ -639,24 +782,21 @@ class Deque {
    * elements of the container with
    */
   //rvalue параметр, для того чтобы забрать ресурсы из other. Используется для оптимизации работы с большими объектами
-  //noexcept не генерирует исключения.
+  //noexcept не генерирует исключения. Узлы не копируются: забираем цепочку first..last у other, other остается пустым.
   Deque(Deque&& other) noexcept
   {
-      for(value_type i = 0; i < other.size();i++){
-          Node<value_type> *node = other.get_allocator().allocate(1);
-          node->value = other[i];
-          if(empty()){
-              first = node;
-              last = node;
-          }
-          else{
-              node->previous = last;
-              last -> next = node;
-              last = node;
-              first->previous = last;
-          }
-      }
-      _size = other.size();
+      alloc = other.alloc;
+      first = other.first;
+      last = other.last;
+      _size = other._size;
+      compaction = other.compaction;
+      churn = other.churn;
+      chunks.swap(other.chunks);
+      other.first = nullptr;
+      other.last = nullptr;
+      other._size = 0;
+      other.compaction = Compaction_state();
+      other.churn = 0;
   }
 
   /**
@@ -701,14 +841,10 @@ class Deque {
       Node<value_type>* current = first;
       while(current != nullptr) {
           Node<value_type>* next = current->next;
-          alloc.deallocate(current);
+          release_node(current);
           current = next;
       }
-      if (std::uncaught_exception()) {
-          std::cerr << "~Deque() stack unwinding, not throwing\n";
-      } else {
-          std::cerr << "~Deque() normal case, throwing\n";
-      }
+      drop_compaction_chunk();
   }
 
   /// @brief Copy assignment operator. Replaces the contents with a copy of the
@@ -716,12 +852,14 @@ class Deque {
   /// @param other another container to use as data source
   /// @return *this
 
-  //Перегрузка оператора присваивания.
+  //Перегрузка оператора присваивания. Проходим по узлам other, а не по индексам, чтобы копирование было O(n).
   Deque& operator=(const Deque& other){
+      if(this == &other) return *this;
       clear();
-      for(size_type i = 0; i < other.size();i++){
-          push_back(other[i]);
+      for(Node<value_type>* cur = other.first; cur != nullptr; cur = cur->next){
+          push_back(cur->value);
       }
+      return *this;
   }
 
   /**
@@ -735,12 +873,12 @@ class Deque {
    * @return *this
    */
 
-  //Перегрузка оператора присваивания используя rvalue
+  //Перегрузка оператора присваивания используя rvalue. Свои узлы освобождаем, узлы other забираем целиком.
   Deque& operator=(Deque&& other){
+      if(this == &other) return *this;
       clear();
-      for(size_type i = 0; i < other.size();i++){
-          push_back(std::move(other[i]));
-      }
+      swap(other);
+      return *this;
   }
 
   /// @brief Replaces the contents with those identified by initializer list
@@ -826,40 +964,36 @@ class Deque {
   }
 
   /// @brief Returns a reference to the element at specified location pos. No
-  /// bounds checking is performed.
+  /// bounds checking is performed unless Policy::checked_index is set.
   /// @param pos position of the element to return
   /// @return Reference to the requested element.
+  /// @throw std::out_of_range with Policy::checked_index only
 
-  //Возвращает ссылку на [pos] элемент. Обходим узлы и проверяем значение value в каждом.
+  //Возвращает ссылку на [pos] элемент: проходим pos узлов от first.
   reference operator[](size_type pos){
-      size_type it = 0;
-      for(Node<value_type>* cur = first; cur != nullptr;cur = cur->next)
-      {
-          if(pos == it)
-          {
-              return cur->value;
-          }
-          it++;
+      if constexpr (Policy::checked_index){
+          if(pos >= _size) throw std::out_of_range("index out of range");
       }
+      Node<value_type>* cur = first;
+      for(size_type i = 0; i < pos; i++) cur = cur->next;
+      return cur->value;
   }
 
   /// @brief Returns a const reference to the element at specified location pos.
-  /// No bounds checking is performed.
+  /// No bounds checking is performed unless Policy::checked_index is set.
   /// @param pos position of the element to return
   /// @return Const Reference to the requested element.
+  /// @throw std::out_of_range with Policy::checked_index only
 
   //Все тоже самое только const ссылка.
   //const нужно для того чтобы предотвратить изменение значений вне класса.
   const_reference operator[](size_type pos) const{
-      size_type it = 0;
-      for(Node<value_type>* cur = first; cur != nullptr;cur = cur->next)
-      {
-          if(pos == it)
-          {
-              return cur->value;
-          }
-          it++;
+      if constexpr (Policy::checked_index){
+          if(pos >= _size) throw std::out_of_range("index out of range");
       }
+      Node<value_type>* cur = first;
+      for(size_type i = 0; i < pos; i++) cur = cur->next;
+      return cur->value;
   }
 
   /// @brief Returns a reference to the first element in the container.
@@ -898,6 +1032,7 @@ class Deque {
   iterator begin() noexcept{
       iterator a;
       a.cur = first;
+      a.tail = &last;
       return a;
   }
 
@@ -907,6 +1042,7 @@ class Deque {
   const_iterator begin() const noexcept{
       const_iterator a;
       a.cur = first;
+      a.tail = &last;
       return a;
   }
 
@@ -914,6 +1050,7 @@ class Deque {
    const_iterator cbegin() const noexcept{
       const_iterator a;
       a.cur = first;
+      a.tail = &last;
       return a;
   }
 
@@ -923,7 +1060,8 @@ class Deque {
   /// @return Iterator to the element following the last element.
   iterator end() noexcept{
       iterator a;
-      a.cur = last;
+      a.cur = nullptr;
+      a.tail = &last;
       return a;
   }
 
@@ -932,16 +1070,15 @@ class Deque {
   /// access it results in undefined behavior.
   /// @return Constant Iterator to the element following the last element.
   const_iterator end() const noexcept{
-      const_iterator a;;
-      a.cur = last;
+      const_iterator a;
+      a.cur = nullptr;
+      a.tail = &last;
       return a;
   }
 
   /// @brief Same to end()
   const_iterator cend() const noexcept{
-      const_iterator a;
-      a.cur = last;
-      return a;
+      return end();
   }
 
   /// @brief Returns a reverse iterator to the first element of the reversed
@@ -949,10 +1086,10 @@ class Deque {
   /// the deque is empty, the returned iterator is equal to rend().
   /// @return Reverse iterator to the first element.
 
-  //Создается временный объект класса deque reverse iterator который  инициализируется итератором на начало контейнера
-  //begin() должен возвращать итератор на первый элемент контейнера, а deque reverse iterator - обертка над deque iteraеtor
+  //Создается временный объект класса deque reverse iterator который  инициализируется итератором на конец контейнера,
+  //разыменование обратного итератора дает элемент перед основным итератором, т.е. последний элемент.
   reverse_iterator rbegin() noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(begin());
+      reverse_iterator a(end());
       return a;
   }
 
@@ -963,15 +1100,14 @@ class Deque {
 
   //Возвращение константного итератора
   const_reverse_iterator rbegin() const noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(begin());
+      const_reverse_iterator a(end());
       return a;
   }
 
   /// @brief Same to rbegin()
   //Возвращение константного итератора
   const_reverse_iterator crbegin() const noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(begin());
-      return a;
+      return rbegin();
   }
 
   /// @brief Returns a reverse iterator to the element following the last
@@ -980,7 +1116,7 @@ class Deque {
   /// placeholder, attempting to access it results in undefined behavior.
   /// @return Reverse iterator to the element following the last element.
   reverse_iterator rend() noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(end());
+      reverse_iterator a(begin());
       return a;
   }
 
@@ -990,14 +1126,13 @@ class Deque {
   /// placeholder, attempting to access it results in undefined behavior.
   /// @return Const Reverse iterator to the element following the last element.
   const_reverse_iterator rend() const noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(end());
+      const_reverse_iterator a(begin());
       return a;
   }
 
   /// @brief Same to rend()
   const_reverse_iterator crend() const noexcept{
-      Deque_reverse_iterator<Deque_iterator<value_type>> a(end());
-      return a;
+      return rend();
   }
 
   /// CAPACITY
@@ -1021,7 +1156,7 @@ class Deque {
 
   //Возвращает максимально возможное число колва элементов, которое может содержать контейнер
   size_type max_size() const noexcept{
-      return std::numeric_limits<size_t>::max();
+      return std::numeric_limits<size_t>::max() / sizeof(Node<value_type>);
   }
 
   /// @brief Requests the removal of unused capacity.
@@ -1049,15 +1184,11 @@ class Deque {
   /// @return Iterator pointing to the inserted value.
   //Вставляем value перед pos. Создаем новый узел
   iterator insert(const_iterator pos, const T& value){
-        Node<value_type>* cur = alloc.allocate(1);
-        cur->value = value;
-        cur->next = pos.cur;
-        cur->previous = pos.cur->previous;
-        pos.cur->previous->next = cur;
-        pos.cur->previous = cur;
-        _size++;
+        Node<value_type>* cur = create_node(value);
+        link_chain(pos.cur, cur, cur, 1);
         iterator a;
         a.cur = cur;
+        a.tail = &last;
         return a;
   }
 
@@ -1067,15 +1198,11 @@ class Deque {
   /// @return Iterator pointing to the inserted value.
   //Вставка value перед pos. Создаем новый узел.
   iterator insert(const_iterator pos, T&& value){
-      Node<value_type>* cur = alloc.allocate(1);
-      cur->value = std::move(value);
-      cur->next = pos.cur;
-      cur->previous = pos.cur->previous;
-      pos.cur->previous->next = cur;
-      pos.cur->previous = cur;
-      _size++;
+      Node<value_type>* cur = create_node(std::move(value));
+      link_chain(pos.cur, cur, cur, 1);
       iterator a;
       a.cur = cur;
+      a.tail = &last;
       return a;
   }
 
@@ -1087,19 +1214,17 @@ class Deque {
   /// == 0.
   //Инсерт нескольких элементов перед pos. 
   iterator insert(const_iterator pos, size_type count, const T& value){
-      Node<value_type>* cur_;
+      Node<value_type>* inserted = pos.cur;
+      bool none = true;
       for(size_type i = 0; i < count; i++){
-          Node<value_type>* cur = alloc.allocate(1);
-          cur->value = value;
-          cur->next = pos.cur;
-          cur->previous = pos.cur->previous;
-          pos.cur->previous->next = cur;
-          pos.cur->previous = cur;
-          _size++;
-          cur_ = cur;
+          Node<value_type>* cur = create_node(value);
+          link_chain(pos.cur, cur, cur, 1);
+          if(none) inserted = cur;
+          none = false;
       }
       iterator a;
-      a.cur = cur_;
+      a.cur = inserted;
+      a.tail = &last;
       return a;
   }
 
@@ -1113,19 +1238,17 @@ class Deque {
   //insert элементов от итераторов first до last перед позицией pos
   template <class InputIt>
   iterator insert(const_iterator pos, InputIt first, InputIt last){
-      Node<value_type>* cur_;
+      Node<value_type>* inserted = pos.cur;
+      bool none = true;
       for(InputIt i = first; i != last; i++){
-          Node<value_type>* cur = alloc.allocate(1);
-          cur->value = *i;
-          cur->next = pos.cur;
-          cur->previous = pos.cur->previous;
-          pos.cur->previous->next = cur;
-          pos.cur->previous = cur;
-          _size++;
-          cur_ = cur;
+          Node<value_type>* cur = create_node(*i);
+          link_chain(pos.cur, cur, cur, 1);
+          if(none) inserted = cur;
+          none = false;
       }
       iterator a;
-      a.cur = cur_;
+      a.cur = inserted;
+      a.tail = &last;
       return a;
   }
 
@@ -1136,19 +1259,17 @@ class Deque {
   /// is empty.
   //insert элементов из ilist перед pos.
   iterator insert(const_iterator pos, std::initializer_list<T> ilist){
-      Node<value_type>* cur_;
+      Node<value_type>* inserted = pos.cur;
+      bool none = true;
       for(auto i: ilist){
-          Node<value_type>* cur = alloc.allocate(1);
-          cur->value = i;
-          cur->next = pos.cur;
-          cur->previous = pos.cur->previous;
-          pos.cur->previous->next = cur;
-          pos.cur->previous = cur;
-          _size++;
-          cur_ = cur;
+          Node<value_type>* cur = create_node(i);
+          link_chain(pos.cur, cur, cur, 1);
+          if(none) inserted = cur;
+          none = false;
       }
       iterator a;
-      a.cur = cur_;
+      a.cur = inserted;
+      a.tail = &last;
       return a;
   }
 
@@ -1159,81 +1280,44 @@ class Deque {
   //move rvalue args перед pos.
   template <class... Args>
   iterator emplace(const_iterator pos, Args&&... args){
-      Node<value_type>* cur = alloc.allocate(1);
-      cur->value = std::move(value_type(args...));
-      cur->next = pos.cur;
-      cur->previous = pos.cur->previous;
-      pos.cur->previous->next = cur;
-      pos.cur->previous = cur;
-      _size++;
+      Node<value_type>* cur = create_node(std::forward<Args>(args)...);
+      link_chain(pos.cur, cur, cur, 1);
       iterator a;
       a.cur = cur;
+      a.tail = &last;
       return a;
   }
 
   /// @brief Removes the element at pos.
   /// @param pos iterator to the element to remove
   /// @return Iterator following the last removed element.
-  //Удаляем элемент на который указывает итератор pos, проверяем разные случае, когда в деке 1 элемент, когда несколько,
-  //также, куда указывает итератор pos, на какой элемент, случаи когда указывает на first или last
+  //Удаляем элемент на который указывает итератор pos: соседи (или first/last, если pos крайний) перевешиваются
+  //друг на друга, узел освобождается. Возвращается итератор на следующий элемент, для последнего - end().
   iterator erase(const_iterator pos){
-      if(pos.cur == first){
-          if(_size == 1){
-              clear();
-          }
-          else {
-              Node<value_type> *cur = first;
-              first = first->next;
-              first->previous = nullptr;
-              _size--;
-              alloc.deallocate(cur);
-          }
-          iterator a;
-          a.cur = first;
-          return a;
-      }
-      if(pos.cur == last){
-          Node<value_type> *cur = last;
-          last = last->previous;
-          last->next = nullptr;
-          iterator a;
-          a.cur = last;
-          _size--;
-          return a;
-      }
-      Node<value_type> *cur = pos.cur->next;
-      pos.cur->previous->next = pos.cur->next;
-      pos.cur->next->previous = pos.cur->previous;
-      alloc.deallocate(pos.cur);
+      Node<value_type>* cur = pos.cur;
+      if(cur->previous == nullptr) first = cur->next;
+      else cur->previous->next = cur->next;
+      if(cur->next == nullptr) last = cur->previous;
+      else cur->next->previous = cur->previous;
       _size--;
       iterator a;
-      a.cur = cur;
+      a.cur = cur->next;
+      a.tail = &last;
+      release_node(cur);
       return a;
   }
 
   /// @brief Removes the elements in the range [first, last).
   /// @param first,last range of elements to remove
   /// @return Iterator following the last removed element.
-  //Удаляем элементы от first до last, проверяем также случаи, куда указывает first и last.
+  //Удаляем элементы от first до last по одному, last может быть end().
   iterator erase(const_iterator first, const_iterator last){
-      if(first == cbegin() && last == cend()){
-          clear();
-          iterator a;
-          a.cur = this->first;
-          return a;
-      }
-      if(first == cbegin()) {
-          this->first = last.cur;
-          this->first->previous = nullptr;
-      }
-      const_iterator cur = first;
-      while (cur.cur != last.cur){
-          erase(cur);
-          cur++;
-          _size--;
+      while(first != last){
+          first = erase(first);
       }
       iterator a;
       a.cur = last.cur;
+      a.tail = &this->last;
       return a;
   }
 
@@ -1243,8 +1327,7 @@ class Deque {
   //Реализуем метод push_back, передается value по ссылке, выделяем память под новый узел
   //переставляем указатели.
   void push_back(const T& value){
-      Node<value_type> *node = get_allocator().allocate(1);
-      node->value = value;
+      Node<value_type> *node = create_node(value);
       node->next = nullptr;
       node->previous = last;
       if(empty()){
@@ -1256,6 +1339,7 @@ class Deque {
           last = node;
       }
       _size++;
+      maybe_compact();
   }
 
   /// @brief Appends the given element value to the end of the container.
@@ -1263,8 +1347,7 @@ class Deque {
   /// @param value the value of the element to append
   //Все тоже самое что сверху, только передаем rvalue значение, используем move.
   void push_back(T&& value){
-      Node<value_type> *node = get_allocator().allocate(1);
-      node->value = std::move(value);
+      Node<value_type> *node = create_node(std::move(value));
       node->next = nullptr;
       node->previous = last;
       if(empty()){
@@ -1276,6 +1359,7 @@ class Deque {
           last = node;
       }
       _size++;
+      maybe_compact();
   }
 
   /// @brief Appends a new element to the end of the container.
@@ -1292,7 +1376,7 @@ class Deque {
   //Удаляем последний элемент. Проверяем если first == last, то подчищаем память и случай когда first != last.
   void pop_back(){
       if(last == first){
-          alloc.deallocate(first);
+          release_node(first);
           last = nullptr;
           first = nullptr;
           _size--;
@@ -1301,46 +1385,49 @@ class Deque {
       Node<value_type> *del = last;
       last = last->previous;
       last->next = nullptr;
-      get_allocator().deallocate(del);
+      release_node(del);
       _size--;
+      maybe_compact();
   }
 
   /// @brief Prepends the given element value to the beginning of the container.
   /// @param value the value of the element to prepend
   //Реализуем push_front, передаем ссылку на value, переносим все указатели куда нужно.
   void push_front(const T& value){
-      Node<value_type>* node = get_allocator().allocate(1);
-      node -> value = value;
+      Node<value_type>* node = create_node(value);
       node->next = first;
       node->previous = nullptr;
       if (empty())
       {
           first = node;
           last = node;
+          _size++;
           return;
       }
       first->previous = node;
       first = node;
       _size++;
+      maybe_compact();
   }
 
   /// @brief Prepends the given element value to the beginning of the container.
   /// @param value moved value of the element to prepend
   //тоже самое, только передаем rvalue value.
   void push_front(T&& value){
-      Node<value_type>* node = get_allocator().allocate(1);
-      node -> value = std::move(value);
+      Node<value_type>* node = create_node(std::move(value));
       node->next = first;
       node->previous = nullptr;
       if (empty())
       {
           first = node;
           last = node;
+          _size++;
           return;
       }
       first->previous = node;
       first = node;
       _size++;
+      maybe_compact();
   }
 
   /// @brief Inserts a new element to the beginning of the container.
@@ -1357,7 +1444,7 @@ class Deque {
   //Удаляем элемент с начала. Проверяем, если контейнер из 1 элемента или нет.
   void pop_front(){
       if(last == first){
-          alloc.deallocate(first);
+          release_node(first);
           last = nullptr;
           first = nullptr;
           _size--;
@@ -1366,8 +1453,9 @@ class Deque {
       Node<value_type> *del = first;
       first = first->next;
       first->previous = nullptr;
-      get_allocator().deallocate(del);
+      release_node(del);
       _size--;
+      maybe_compact();
   }
 
   /// @brief Resizes the container to contain count elements.
@@ -1409,10 +1497,518 @@ class Deque {
   void swap(Deque& other){
       Node<value_type>* f = first;
       Node<value_type>* l = last;
+      size_type s = _size;
       first = other.first;
       last = other.last;
+      _size = other._size;
       other.first = f;
       other.last = l;
+      other._size = s;
+      std::swap(compaction, other.compaction);
+      std::swap(churn, other.churn);
+      chunks.swap(other.chunks);
+  }
+
+  /// @brief Transfers all elements from other into *this. The elements are
+  /// inserted before pos. No elements are copied or moved, only the node links
+  /// are changed. other becomes empty. Complexity: constant.
+  /// @param pos iterator before which the content will be inserted; end()
+  /// inserts at the back
+  /// @param other another container to transfer the content from
+  //Переносим всю цепочку узлов other перед pos, просто переставляя указатели.
+  void splice(const_iterator pos, Deque& other){
+      if(this == &other || other.empty()) return;
+      Node<value_type>* f = other.first;
+      Node<value_type>* l = other.last;
+      size_type count = other._size;
+      other.first = nullptr;
+      other.last = nullptr;
+      other._size = 0;
+      //Курсор прохода compact в other указывает на узлы, которые теперь наши, а недозаполненный блок other не нужен.
+      other.drop_compaction_chunk();
+      other.restart_compaction();
+      if(!other.chunks.empty()) chunks.share(other.chunks);
+      link_chain(pos.cur, f, l, count);
+  }
+
+  /// @brief Transfers the elements in the range [first, last) from other into
+  /// *this. The elements are inserted before pos. No elements are copied or
+  /// moved. other may be *this, in which case pos must not be in [first, last).
+  /// Complexity: linear in the length of the range when other is not *this
+  /// (the size has to be counted), constant otherwise.
+  /// @param pos iterator before which the content will be inserted; end()
+  /// inserts at the back
+  /// @param other another container to transfer the content from
+  /// @param first,last the range of elements to transfer; last may be
+  /// other.end()
+  //Вырезаем цепочку [first, last) из other и вставляем ее перед pos.
+  void splice(const_iterator pos, Deque& other, const_iterator first, const_iterator last){
+      if(first.cur == last.cur) return;
+      if(this == &other && pos.cur == last.cur) return;
+      Node<value_type>* f = first.cur;
+      Node<value_type>* l = last.cur == nullptr ? other.last : last.cur->previous;
+      size_type count = 0;
+      if(this != &other){
+          for(Node<value_type>* cur = f; cur != l; cur = cur->next) count++;
+          count++;
+      }
+      other.unlink_chain(f, l, count);
+      if(this != &other && !other.chunks.empty()) chunks.share(other.chunks);
+      link_chain(pos.cur, f, l, count);
+  }
+
+  /// @brief Moves all elements of other to the back of *this by relinking
+  /// nodes. other becomes empty. Complexity: constant.
+  /// @param other container to append
+  void append(Deque&& other){
+      splice(cend(), other);
+  }
+
+  /// @brief Splits the container in two. Elements [index, size()) are moved
+  /// into the returned container, *this keeps [0, index). No elements are
+  /// copied or moved. Complexity: linear in min(index, size() - index).
+  /// @param index position of the first element of the tail
+  /// @return Container holding the tail.
+  //Ищем узел index с ближайшего конца и разрываем цепочку перед ним.
+  Deque split_at(size_type index){
+      Deque tail;
+      if(index >= _size) return tail;
+      if(index == 0){
+          swap(tail);
+          return tail;
+      }
+      Node<value_type>* cur;
+      if(index <= _size - index){
+          cur = first;
+          for(size_type i = 0; i < index; i++) cur = cur->next;
+      }
+      else{
+          cur = last;
+          for(size_type i = _size - 1; i > index; i--) cur = cur->previous;
+      }
+      restart_compaction();
+      if(!chunks.empty()) tail.chunks.share(chunks);
+      tail.first = cur;
+      tail.last = last;
+      tail._size = _size - index;
+      last = cur->previous;
+      last->next = nullptr;
+      cur->previous = nullptr;
+      _size = index;
+      return tail;
+  }
+
+  /// @brief Rotates the elements so that the element at position k becomes
+  /// the first one (as std::rotate(begin, begin + k, end)). Only the node links
+  /// change, nothing is allocated, copied or moved.
+  /// Complexity: linear in min(k, size() - k).
+  /// @param k number of positions to rotate to the left, taken modulo size()
+  //Замыкаем цепочку в кольцо и разрываем его перед новым первым элементом.
+  void rotate(size_type k){
+      if(_size < 2) return;
+      k %= _size;
+      if(k == 0) return;
+      Node<value_type>* cur;
+      if(k <= _size - k){
+          cur = first;
+          for(size_type i = 0; i < k; i++) cur = cur->next;
+      }
+      else{
+          cur = last;
+          for(size_type i = _size - 1; i > k; i--) cur = cur->previous;
+      }
+      restart_compaction();
+      last->next = first;
+      first->previous = last;
+      first = cur;
+      last = cur->previous;
+      first->previous = nullptr;
+      last->next = nullptr;
+  }
+
+  /// @brief Copies all elements, in order, into the caller's buffer out,
+  /// which must have room for size() elements. The elements live in separate
+  /// nodes next to their links, so they cannot be laid out as one array in
+  /// place: this is a copy, and later modifications of the deque are not
+  /// reflected in it. Nothing is allocated.
+  /// Complexity: linear in size().
+  /// @param out buffer for size() elements
+  /// @return Pointer past the last copied element.
+  value_type* make_contiguous(value_type* out) const{
+      for(Node<value_type>* cur = first; cur != nullptr; cur = cur->next){
+          *out++ = cur->value;
+      }
+      return out;
+  }
+
+  /// @brief Same to make_contiguous(out)
+  value_type* linearize(value_type* out) const{
+      return make_contiguous(out);
+  }
+
+  /// @brief Moves all nodes into one freshly allocated contiguous chunk, in
+  /// list order, so that iteration walks memory sequentially. Does nothing if
+  /// the nodes are already laid out in order.
+  /// Invalidates all iterators, pointers and references to the elements.
+  /// Complexity: linear in size().
+  void compact(){
+      drop_compaction_chunk();
+      restart_compaction();
+      if(_size < 2 || fragmentation() == 0) return;
+      start_compaction_chunk(_size);
+      for(Node<value_type>* cur = first; cur != nullptr; cur = cur->next){
+          cur = relocate_node(cur);
+      }
+      drop_compaction_chunk();
+      churn = 0;
+  }
+
+  /// @brief Incremental version of compact(). Examines at most max_nodes
+  /// nodes, continuing where the previous call stopped, and moves every node
+  /// that does not directly follow its predecessor in memory into the current
+  /// chunk. Chunks hold chunk_nodes() nodes each.
+  /// Invalidates iterators, pointers and references to the moved elements.
+  /// Complexity: linear in max_nodes.
+  /// @param max_nodes bound on the work done by this call
+  /// @return true if the pass reached the back of the deque.
+  //Узел считается стоящим на месте, если он лежит в памяти сразу за своим предыдущим узлом.
+  bool compact(size_type max_nodes){
+      if(compaction.cursor == nullptr) compaction.cursor = first;
+      for(size_type i = 0; i < max_nodes && compaction.cursor != nullptr; i++){
+          Node<value_type>* cur = compaction.cursor;
+          if(!in_place(cur)) cur = relocate_node(cur);
+          compaction.cursor = cur->next;
+      }
+      if(compaction.cursor != nullptr) return false;
+      compaction.chunk_capacity = 0;
+      churn = 0;
+      return true;
+  }
+
+  /// @brief Enables automatic compaction. After every push_back, push_front,
+  /// pop_back and pop_front, once the number of node allocations and
+  /// deallocations since the last completed pass exceeds threshold * size(),
+  /// compact(step) is run, so the cost is spread over many operations.
+  /// With automatic compaction on, these modifiers may relocate nodes and
+  /// invalidate iterators and references to any element.
+  /// @param threshold churn to size ratio, 0 disables automatic compaction
+  /// @param step number of nodes examined per operation
+  void set_compaction_threshold(double threshold, size_type step = 64){
+      compaction_threshold = threshold;
+      compaction_step = step;
+  }
+
+  /// @brief Returns the share of neighbouring elements that are not adjacent
+  /// in memory: 0 for a fully compacted deque, close to 1 for scattered nodes.
+  /// Complexity: linear in size().
+  double fragmentation() const noexcept{
+      if(_size < 2) return 0;
+      size_type breaks = 0;
+      for(Node<value_type>* cur = first->next; cur != nullptr; cur = cur->next){
+          if(!follows(cur->previous, cur)) breaks++;
+      }
+      return static_cast<double>(breaks) / static_cast<double>(_size - 1);
+  }
+
+  /// @brief Number of nodes in the first chunk allocated by a
+  /// compact(max_nodes) pass: Policy::chunk_nodes, or about 16 KiB worth of
+  /// nodes (at least 64) when the policy leaves it at 0. Later chunks of the
+  /// same pass grow by Policy::chunk_growth.
+  static constexpr size_type chunk_nodes() noexcept{
+      if constexpr (Policy::chunk_nodes != 0) return Policy::chunk_nodes;
+      return 16384 / sizeof(Node<value_type>) > 64 ? 16384 / sizeof(Node<value_type>) : 64;
+  }
+
+  /// @brief Allocation counters. Available only with Policy::statistics.
+  template <typename P = Policy, typename = std::enable_if_t<P::statistics>>
+  const Deque_statistics& statistics() const noexcept{
+      return stats;
+  }
+
+  /// @brief Writes the deque to out in the versioned binary snapshot format:
+  /// a header (magic "FDQS", format version, flags, element size, element
+  /// count) followed by the elements. T must be trivially copyable; the
+  /// elements are gathered into a buffer and written in large blocks, in the
+  /// native byte order.
+  /// @param out stream to write to
+  /// @throw std::runtime_error if the stream fails
+  void save(std::ostream& out) const{
+      static_assert(std::is_trivially_copyable<value_type>::value,
+                    "save(out) needs a trivially copyable T, pass a serializer otherwise");
+      write_snapshot_header(out, snapshot_raw);
+      const size_type per_buffer = snapshot_buffer_elements();
+      std::vector<char> buffer(per_buffer * sizeof(value_type));
+      size_type used = 0;
+      for(Node<value_type>* cur = first; cur != nullptr; cur = cur->next){
+          std::memcpy(buffer.data() + used * sizeof(value_type), &cur->value, sizeof(value_type));
+          if(++used == per_buffer){
+              write_snapshot_bytes(out, buffer.data(), used * sizeof(value_type));
+              used = 0;
+          }
+      }
+      write_snapshot_bytes(out, buffer.data(), used * sizeof(value_type));
+  }
+
+  /// @brief Writes the deque to out in the versioned binary snapshot format,
+  /// using serializer for every element.
+  /// @param out stream to write to
+  /// @param serializer callable as serializer(std::ostream&, const T&)
+  /// @throw std::runtime_error if the stream fails
+  template <class Serializer>
+  void save(std::ostream& out, Serializer serializer) const{
+      write_snapshot_header(out, 0);
+      for(Node<value_type>* cur = first; cur != nullptr; cur = cur->next){
+          serializer(out, cur->value);
+      }
+      if(!out) throw std::runtime_error("Deque::save: write failed");
+  }
+
+  /// @brief Replaces the contents with a snapshot written by save(out). The
+  /// elements are read in large blocks and constructed straight into one
+  /// contiguous chunk of nodes, so the loaded deque is already compacted.
+  /// The chunk is freed only when the last of its nodes is erased: erasing
+  /// most of a loaded deque returns no memory while any loaded element is
+  /// left. Copy the survivors into a new deque to release it earlier.
+  /// The element count in the header is checked against max_size() and, for
+  /// seekable streams, against the bytes left in the stream before anything
+  /// is allocated; the contents are left unchanged if the header is rejected.
+  /// @param in stream to read from
+  /// @throw std::runtime_error if the snapshot is truncated, has an
+  /// impossible element count, was written by a different format version,
+  /// element size or with a serializer
+  void load(std::istream& in){
+      static_assert(std::is_trivially_copyable<value_type>::value,
+                    "load(in) needs a trivially copyable T, pass a deserializer otherwise");
+      size_type count = read_snapshot_header(in, snapshot_raw);
+      check_snapshot_length(in, count);
+      clear();
+      if(count == 0) return;
+      drop_compaction_chunk();
+      Node<value_type>* nodes = chunks.allocate(count, alloc);
+      if constexpr (Policy::statistics) stats.chunk_allocations++;
+      const size_type per_buffer = snapshot_buffer_elements();
+      size_type done = 0;
+      try{
+          std::vector<char> buffer(per_buffer * sizeof(value_type));
+          while(done < count){
+              size_type batch = count - done < per_buffer ? count - done : per_buffer;
+              read_snapshot_bytes(in, buffer.data(), batch * sizeof(value_type));
+              for(size_type i = 0; i < batch; i++, done++){
+                  Node<value_type>* node = nodes + done;
+                  ::new (static_cast<void*>(node)) Node<value_type>{value_type(), nullptr, nullptr};
+                  std::memcpy(&node->value, buffer.data() + i * sizeof(value_type), sizeof(value_type));
+              }
+          }
+      }
+      catch(...){
+          chunks.release(nodes, alloc);
+          throw;
+      }
+      for(size_type i = 0; i < count; i++){
+          nodes[i].previous = i == 0 ? nullptr : nodes + i - 1;
+          nodes[i].next = i + 1 == count ? nullptr : nodes + i + 1;
+      }
+      //Блок держал одну ссылку с момента выделения, она переходит первому узлу.
+      if(count > 1) chunks.retain(nodes, count - 1);
+      first = nodes;
+      last = nodes + count - 1;
+      _size = count;
+  }
+
+  /// @brief Replaces the contents with a snapshot written by
+  /// save(out, serializer).
+  /// @param in stream to read from
+  /// @param deserializer callable as deserializer(std::istream&), returning T
+  /// @throw std::runtime_error if the header does not match
+  template <class Deserializer>
+  void load(std::istream& in, Deserializer deserializer){
+      size_type count = read_snapshot_header(in, 0);
+      clear();
+      for(size_type i = 0; i < count; i++){
+          push_back(deserializer(in));
+      }
+      if(!in) throw std::runtime_error("Deque::load: snapshot is truncated");
+  }
+
+  //Вставляет готовую цепочку узлов f..l (count штук) перед узлом before, before == nullptr означает вставку в конец.
+  void link_chain(Node<value_type>* before, Node<value_type>* f, Node<value_type>* l, size_type count){
+      Node<value_type>* after = before == nullptr ? last : before->previous;
+      f->previous = after;
+      l->next = before;
+      if(after == nullptr) first = f;
+      else after->next = f;
+      if(before == nullptr) last = l;
+      else before->previous = l;
+      _size += count;
+  }
+
+  //Вырезает цепочку узлов f..l (count штук) из дека, сами узлы не освобождаются.
+  void unlink_chain(Node<value_type>* f, Node<value_type>* l, size_type count){
+      restart_compaction();
+      if(f->previous == nullptr) first = l->next;
+      else f->previous->next = l->next;
+      if(l->next == nullptr) last = f->previous;
+      else l->next->previous = f->previous;
+      f->previous = nullptr;
+      l->next = nullptr;
+      _size -= count;
+  }
+
+  using node_chunks = Node_chunks<Node<value_type>, Allocator>;
+  node_chunks chunks; //Блоки, из которых могут быть узлы этого дека.
+
+  static constexpr std::uint32_t snapshot_version = 1;
+  static constexpr std::uint32_t snapshot_raw = 1; //Флаг: элементы записаны байтами, без сериализатора.
+  //Сколько элементов собирается в буфер перед одной записью или чтением, буфер около 64 КБ.
+  static constexpr size_type snapshot_buffer_elements() noexcept{
+      return 65536 / sizeof(value_type) > 0 ? 65536 / sizeof(value_type) : 1;
+  }
+
+  void write_snapshot_header(std::ostream& out, std::uint32_t flags) const{
+      std::uint32_t header[4] = {0, snapshot_version, flags, static_cast<std::uint32_t>(sizeof(value_type))};
+      std::memcpy(header, "FDQS", 4);
+      std::uint64_t count = _size;
+      write_snapshot_bytes(out, header, sizeof(header));
+      write_snapshot_bytes(out, &count, sizeof(count));
+  }
+
+  //Проверяет заголовок и возвращает число элементов.
+  static size_type read_snapshot_header(std::istream& in, std::uint32_t flags){
+      std::uint32_t header[4];
+      std::uint64_t count;
+      read_snapshot_bytes(in, header, sizeof(header));
+      read_snapshot_bytes(in, &count, sizeof(count));
+      if(std::memcmp(header, "FDQS", 4) != 0) throw std::runtime_error("Deque::load: not a deque snapshot");
+      if(header[1] != snapshot_version) throw std::runtime_error("Deque::load: unsupported snapshot version");
+      if(header[2] != flags) throw std::runtime_error("Deque::load: snapshot was written with a different serializer");
+      if(flags == snapshot_raw && header[3] != sizeof(value_type)) throw std::runtime_error("Deque::load: element size mismatch");
+      if(count > std::numeric_limits<size_type>::max() / sizeof(Node<value_type>)){
+          throw std::runtime_error("Deque::load: element count is too large");
+      }
+      return static_cast<size_type>(count);
+  }
+
+  //Число элементов из заголовка не должно превышать то, что осталось в потоке: иначе поврежденный заголовок
+  //заставил бы выделить блок под несуществующие элементы. Для потоков без позиционирования проверки нет,
+  //короткое чтение все равно остановит load.
+  static void check_snapshot_length(std::istream& in, size_type count){
+      std::istream::pos_type here = in.tellg();
+      if(here == std::istream::pos_type(-1)) return;
+      in.seekg(0, std::ios::end);
+      std::istream::pos_type end = in.tellg();
+      in.clear();
+      in.seekg(here);
+      if(end == std::istream::pos_type(-1)) return;
+      if(static_cast<std::uint64_t>(end - here) / sizeof(value_type) < count){
+          throw std::runtime_error("Deque::load: snapshot is truncated");
+      }
+  }
+
+  static void write_snapshot_bytes(std::ostream& out, const void* data, size_type bytes){
+      if(bytes == 0) return;
+      if(!out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes))){
+          throw std::runtime_error("Deque::save: write failed");
+      }
+  }
+
+  static void read_snapshot_bytes(std::istream& in, void* data, size_type bytes){
+      if(!in.read(static_cast<char*>(data), static_cast<std::streamsize>(bytes))){
+          throw std::runtime_error("Deque::load: snapshot is truncated");
+      }
+  }
+
+  //Все узлы создаются здесь, значение конструируется на месте.
+  template <class... Args>
+  Node<value_type>* create_node(Args&&... args){
+      Node<value_type>* node = alloc.allocate(1);
+      ::new (static_cast<void*>(node)) Node<value_type>{value_type(std::forward<Args>(args)...), nullptr, nullptr};
+      churn++;
+      if constexpr (Policy::statistics) stats.node_allocations++;
+      return node;
+  }
+
+  //Все узлы, удаляемые из дека, освобождаются здесь. Если это был текущий узел compact(max_nodes), проход продолжится со следующего.
+  void release_node(Node<value_type>* node){
+      if(node == compaction.cursor) compaction.cursor = node->next;
+      destroy_node(node);
+      churn++;
+      if constexpr (Policy::statistics) stats.node_deallocations++;
+  }
+
+  //Разрушает и освобождает узел без учета в статистике: перенесенный compact узел считается только в nodes_relocated.
+  void destroy_node(Node<value_type>* node){
+      node->~Node<value_type>();
+      if(!chunks.release(node, alloc)) alloc.deallocate(node);
+  }
+
+  void maybe_compact(){
+      if(compaction_threshold > 0 && churn > compaction_threshold * _size) compact(compaction_step);
+  }
+
+  static bool follows(const Node<value_type>* a, const Node<value_type>* b) noexcept{
+      return reinterpret_cast<std::uintptr_t>(b) - reinterpret_cast<std::uintptr_t>(a) == sizeof(Node<value_type>);
+  }
+
+  static bool in_place(const Node<value_type>* node) noexcept{
+      if(node->previous != nullptr) return follows(node->previous, node);
+      return node->next != nullptr && follows(node, node->next);
+  }
+
+  //Переносит узел в следующую свободную ячейку текущего блока и перевешивает на нее соседей.
+  Node<value_type>* relocate_node(Node<value_type>* node){
+      if(compaction.slot == compaction.slot_end){
+          drop_compaction_chunk();
+          start_compaction_chunk(next_chunk_capacity());
+      }
+      if constexpr (Policy::statistics) stats.nodes_relocated++;
+      Node<value_type>* slot = compaction.slot++;
+      chunks.retain(slot);
+      ::new (static_cast<void*>(slot)) Node<value_type>{std::move(node->value), node->next, node->previous};
+      if(node->previous == nullptr) first = slot;
+      else node->previous->next = slot;
+      if(node->next == nullptr) last = slot;
+      else node->next->previous = slot;
+      destroy_node(node);
+      return slot;
+  }
+
+  //Первый блок прохода - chunk_nodes() узлов, каждый следующий больше в chunk_growth раз (хотя бы на один узел),
+  //но не больше всего дека. Сначала умножение, потом деление, чтобы 3/2 от маленького блока не округлялось вниз;
+  //при переполнении умножения берется предел.
+  size_type next_chunk_capacity() const noexcept{
+      using growth = typename Policy::chunk_growth;
+      const size_type capacity = compaction.chunk_capacity;
+      if(capacity == 0) return chunk_nodes();
+      if constexpr (std::ratio_equal<growth, std::ratio<1>>::value) return capacity;
+      const size_type limit = _size > chunk_nodes() ? _size : chunk_nodes();
+      const size_type num = static_cast<size_type>(growth::num);
+      const size_type den = static_cast<size_type>(growth::den);
+      if(capacity >= limit || capacity > std::numeric_limits<size_type>::max() / num) return limit;
+      size_type grown = capacity * num / den;
+      if(grown <= capacity) grown = capacity + 1;
+      return grown < limit ? grown : limit;
+  }
+
+  void start_compaction_chunk(size_type capacity){
+      compaction.chunk = chunks.allocate(capacity, alloc);
+      compaction.chunk_capacity = capacity;
+      if constexpr (Policy::statistics) stats.chunk_allocations++;
+      compaction.slot = compaction.chunk;
+      compaction.slot_end = compaction.chunk + capacity;
+  }
+
+  //Отпускает ссылку, которую держит незаполненный блок.
+  void drop_compaction_chunk(){
+      if(compaction.chunk == nullptr) return;
+      chunks.release(compaction.chunk, alloc);
+      compaction.chunk = nullptr;
+      compaction.slot = nullptr;
+      compaction.slot_end = nullptr;
+  }
+
+  void restart_compaction() noexcept{
+      compaction.cursor = nullptr;
+      compaction.chunk_capacity = 0;
   }
 
   /// COMPARISIONS
@@ -1421,9 +2017,7 @@ class Deque {
   /// @param lhs,rhs deques whose contents to compare
 
   //Перегрузка оператора ==, для проверки равны ли деки
-  template <class U, class Alloc>
-  friend bool operator==(const Deque<U, Alloc>& lhs,
-                         const Deque<U, Alloc>& rhs){
+  friend bool operator==(const Deque& lhs, const Deque& rhs){
       if(lhs.size() != rhs.size()) return false;
       for(size_type i = 0; i < lhs.size(); i++){
           if(rhs[i] != lhs[i]) return false;
@@ -1433,9 +2027,7 @@ class Deque {
 
   /// @brief Checks if the contents of lhs and rhs are not equal
   /// @param lhs,rhs deques whose contents to compare
-  template <class U, class Alloc>
-  friend bool operator!=(const Deque<U, Alloc>& lhs,
-                         const Deque<U, Alloc>& rhs){
+  friend bool operator!=(const Deque& lhs, const Deque& rhs){
       if(lhs.size() != rhs.size()) return true;
       for(size_type i = 0; i < lhs.size(); i++){
           if(rhs[i] != lhs[i]) return true;
@@ -1445,8 +2037,7 @@ class Deque {
 
   /// @brief Compares the contents of lhs and rhs lexicographically.
   /// @param lhs,rhs deques whose contents to compare
-  template <class U, class Alloc>
-  friend bool operator>(const Deque<U, Alloc>& lhs, const Deque<U, Alloc>& rhs){
+  friend bool operator>(const Deque& lhs, const Deque& rhs){
       if(lhs.size() > rhs.size()) return true;
       else if(lhs.size() < rhs.size()) return false;
       for(size_type i = 0; i < lhs.size(); i++){
@@ -1459,8 +2050,7 @@ class Deque {
 
   /// @brief Compares the contents of lhs and rhs lexicographically.
   /// @param lhs,rhs deques whose contents to compare
-  template <class U, class Alloc>
-  friend bool operator<(const Deque<U, Alloc>& lhs, const Deque<U, Alloc>& rhs){
+  friend bool operator<(const Deque& lhs, const Deque& rhs){
       if(lhs.size() < rhs.size()) return true;
       else if(lhs.size() < rhs.size()) return false;
       for(size_type i = 0; i < lhs.size(); i++){
@@ -1473,9 +2063,7 @@ class Deque {
 
   /// @brief Compares the contents of lhs and rhs lexicographically.
   /// @param lhs,rhs deques whose contents to compare
-  template <class U, class Alloc>
-  friend bool operator>=(const Deque<U, Alloc>& lhs,
-                         const Deque<U, Alloc>& rhs){
+  friend bool operator>=(const Deque& lhs, const Deque& rhs){
       if(lhs.size() > rhs.size()) return true;
       else if(lhs.size() < rhs.size()) return false;
       for(size_type i = 0; i < lhs.size(); i++){
@@ -1488,9 +2076,7 @@ class Deque {
 
   /// @brief Compares the contents of lhs and rhs lexicographically.
   /// @param lhs,rhs deques whose contents to compare
-  template <class U, class Alloc>
-  friend bool operator<=(const Deque<U, Alloc>& lhs,
-                         const Deque<U, Alloc>& rhs){
+  friend bool operator<=(const Deque& lhs, const Deque& rhs){
       if(lhs.size() < rhs.size()) return true;
       else if(lhs.size() < rhs.size()) return false;
       for(size_type i = 0; i < lhs.size(); i++){
@@ -1501,19 +2087,18 @@ class Deque {
       return true;
   }
 
-  //Получаем iterator значения val, пробегаемся по деку, ищем наш элемент и возвращаем итератор указывающий на него
-  const_iterator get_iter(value_type val){
-      size_type it = 0;
-      for(Node<value_type>* cur = first; cur != nullptr;cur = cur->next)
-      {
-          if(cur->value == val)
-          {
-              const_iterator a;
+  //Получаем iterator значения val, пробегаемся по деку, ищем наш элемент и возвращаем итератор указывающий на него.
+  //Если элемента нет, возвращается итератор с cur == nullptr.
+  const_iterator get_iter(const value_type& val) const{
+      const_iterator a;
+      a.cur = nullptr;
+      for(Node<value_type>* cur = first; cur != nullptr; cur = cur->next){
+          if(cur->value == val){
               a.cur = cur;
-              return a;
+              break;
           }
-          it++;
       }
+      return a;
   }
 
   // operator <=> will be handy
@@ -1523,14 +2108,9 @@ class Deque {
 
 /// @brief  Swaps the contents of lhs and rhs.
 /// @param lhs,rhs containers whose contents to swap
-template <class T, class Alloc>
-void swap(Deque<T, Alloc>& lhs, Deque<T, Alloc>& rhs){
-    Node<T> *first = lhs.first;
-    Node<T> *last = lhs.last;
-    lhs.first = rhs.first;
-    lhs.last = rhs.last;
-    rhs.first = first;
-    rhs.last = last;
+template <class T, class Alloc, class Policy>
+void swap(Deque<T, Alloc, Policy>& lhs, Deque<T, Alloc, Policy>& rhs){
+    lhs.swap(rhs);
 }
 
 /// @brief Erases all elements that compare equal to value from the container.
@@ -1538,29 +2118,41 @@ void swap(Deque<T, Alloc>& lhs, Deque<T, Alloc>& rhs){
 /// @param value value to be removed
 /// @return The number of erased elements.
 //erase элемента value, полученного по ссылке в Deque c
-template <class T, class Alloc, typename U>
-typename Deque<T, Alloc>::size_type erase(Deque<T, Alloc>& c, const U& value){
-    for(size_t i = 0; i < c.size();i++){
-        if(c[i] == value){
-            c.erase(c.get_iter(value));
-            return i;
+template <class T, class Alloc, class Policy, typename U>
+typename Deque<T, Alloc, Policy>::size_type erase(Deque<T, Alloc, Policy>& c, const U& value){
+    typename Deque<T, Alloc, Policy>::size_type count = 0;
+    typename Deque<T, Alloc, Policy>::const_iterator pos;
+    for(Node<T>* cur = c.first; cur != nullptr;){
+        Node<T>* next = cur->next;
+        if(cur->value == value){
+            pos.cur = cur;
+            c.erase(pos);
+            count++;
         }
+        cur = next;
     }
+    return count;
 }
 
-/// @brief Erases all elements that compare equal to value from the container.era
+/// @brief Erases all elements that satisfy the predicate pred from the container.
 /// @param c container from which to erase
-/// @param pred unary predicate which retgit urns ​true if the element should be
+/// @param pred unary predicate which returns true if the element should be
 /// erased.
 /// @return The number of erased elements.
-//erase if, отличается от erase тем, что pred хранит в себе true, если элемент должен быть удален
-template <class T, class Alloc, class Pred>
-typename Deque<T, Alloc>::size_type erase_if(Deque<T, Alloc>& c, Pred pred){
-        for(size_t i = 0; i < c.size();i++){
-        if(pred[i] == true) {
-            c.erase(pred[i]);
-            return i;
+//erase if, отличается от erase тем, что удаляются элементы, для которых pred вернул true
+template <class T, class Alloc, class Policy, class Pred>
+typename Deque<T, Alloc, Policy>::size_type erase_if(Deque<T, Alloc, Policy>& c, Pred pred){
+    typename Deque<T, Alloc, Policy>::size_type count = 0;
+    typename Deque<T, Alloc, Policy>::const_iterator pos;
+    for(Node<T>* cur = c.first; cur != nullptr;){
+        Node<T>* next = cur->next;
+        if(pred(cur->value)){
+            pos.cur = cur;
+            c.erase(pos);
+            count++;
         }
+        cur = next;
     }
+    return count;
 }
 }  // namespace fefu_laboratory_two
@@ -0,0 +1,152 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек событий с временем жизни ttl. События раскладываются по корзинам шириной bucket_width по своей
+// метке времени, корзины - Deque в порядке времени. expire(now) выбрасывает корзины целиком, пока
+// вся корзина старше ttl: цепочка узлов корзины переносится splice в запасной дек spare за O(1), так что
+// expire стоит O(выброшенных корзин). push берет узлы из spare и перезаписывает в них значение, поэтому
+// значения выброшенных событий разрушаются не в expire, а при повторном использовании узла или в clear().
+// Событие живет от ttl до ttl + bucket_width. Опоздавшие события попадают в свою корзину: поиск идет от последней корзины
+// назад, так что при ограниченном опоздании это несколько шагов.
+template <typename T, typename Clock = std::chrono::steady_clock>
+class ExpiringDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using duration = typename Clock::duration;
+  using time_point = typename Clock::time_point;
+
+  /// @brief Constructs an empty deque.
+  /// @param ttl how long an event is kept
+  /// @param bucket_width time span of one bucket; eviction is accurate to it
+  ExpiringDeque(duration ttl, duration bucket_width)
+      : ttl(ttl), bucket_width(bucket_width > duration::zero() ? bucket_width : duration(1)) {}
+
+  /// @brief Returns the number of events kept
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if no events are kept
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Returns the number of non-empty buckets.
+  size_type bucket_count() const noexcept{
+      return buckets.size();
+  }
+
+  /// @brief Adds value with timestamp at. Timestamps may arrive out of
+  /// order.
+  /// @return false if the event is older than an earlier expire() already
+  /// dropped, in which case it is not stored.
+  bool push(const T& value, time_point at){
+      std::int64_t key = bucket_of(at);
+      if(key < horizon) return false;
+      Deque<T>& items = bucket_for(key).items;
+      if(spare.empty()){
+          items.push_back(value);
+      }
+      else{
+          //Значение пишется до переноса, чтобы исключение из присваивания ничего не меняло.
+          spare.front() = value;
+          typename Deque<T>::const_iterator node = spare.cbegin();
+          typename Deque<T>::const_iterator next = node;
+          ++next;
+          items.splice(items.cend(), spare, node, next);
+      }
+      _size++;
+      return true;
+  }
+
+  /// @brief Adds value stamped with Clock::now().
+  bool push(const T& value){
+      return push(value, Clock::now());
+  }
+
+  /// @brief Drops every bucket whose events are all older than now - ttl.
+  /// The nodes of dropped events are kept for reuse by push().
+  /// Linear in the number of buckets dropped.
+  /// @return Number of events dropped.
+  size_type expire(time_point now){
+      std::int64_t limit = bucket_of(now - ttl);
+      if(limit > horizon) horizon = limit;
+      size_type dropped = 0;
+      while(!buckets.empty() && buckets.front().key < horizon){
+          Deque<T>& items = buckets.front().items;
+          dropped += items.size();
+          spare.splice(spare.cend(), items);
+          buckets.pop_front();
+      }
+      _size -= dropped;
+      return dropped;
+  }
+
+  /// @brief Erases all events and releases the nodes kept for reuse.
+  void clear(){
+      buckets.clear();
+      spare.clear();
+      _size = 0;
+  }
+
+  /// @brief Calls f(value) for every event, bucket by bucket from the
+  /// oldest; events in one bucket come in arrival order.
+  template <class F>
+  void for_each(F f) const{
+      for(Node<Bucket>* bucket = buckets.first; bucket != nullptr; bucket = bucket->next){
+          for(Node<T>* cur = bucket->value.items.first; cur != nullptr; cur = cur->next) f(cur->value);
+      }
+  }
+
+ private:
+  struct Bucket {
+      std::int64_t key = 0; //Номер промежутка [key * bucket_width, (key + 1) * bucket_width).
+      Deque<T> items;
+  };
+
+  std::int64_t bucket_of(time_point at) const{
+      auto ticks = at.time_since_epoch().count();
+      auto width = bucket_width.count();
+      std::int64_t key = static_cast<std::int64_t>(ticks / width);
+      return ticks % width < 0 ? key - 1 : key;
+  }
+
+  //Корзина с номером key: обычно последняя или новая в конце, для опоздавших - ищется с конца.
+  Bucket& bucket_for(std::int64_t key){
+      if(buckets.empty() || buckets.back().key < key){
+          buckets.emplace_back().key = key;
+          return buckets.back();
+      }
+      Node<Bucket>* cur = buckets.last;
+      while(cur != nullptr && cur->value.key > key) cur = cur->previous;
+      if(cur != nullptr && cur->value.key == key) return cur->value;
+      if(cur == nullptr){
+          buckets.emplace_front().key = key;
+          return buckets.front();
+      }
+      //Корзины между cur и следующей нет, вставляем ее на свое место.
+      Deque<Bucket> single;
+      single.emplace_back().key = key;
+      Node<Bucket>* node = single.first;
+      typename Deque<Bucket>::const_iterator pos;
+      pos.cur = cur->next;
+      buckets.splice(pos, single);
+      return node->value;
+  }
+
+  Deque<Bucket> buckets;
+  Deque<T> spare; //Узлы выброшенных событий со старыми значениями, push берет их отсюда.
+  duration ttl;
+  duration bucket_width;
+  std::int64_t horizon = std::numeric_limits<std::int64_t>::min(); //Корзины с меньшим номером уже выброшены.
+  size_type _size = 0;
+};
+
+}  // namespace fefu_laboratory_two
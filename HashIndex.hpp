@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Хеш-таблица с открытой адресацией и линейным пробированием для индексов над узлами дека
+// (ключ -> Node*). Все записи лежат в одном массиве, поэтому поиск - это один-два соседних кэш-промаха,
+// а вставка после прогрева не выделяет память. Удаление сдвигает следующие записи цепочки назад
+// вместо надгробий, так что таблица не деградирует при постоянной смене ключей.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class Hash_index {
+ public:
+  using size_type = std::size_t;
+
+  explicit Hash_index(const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual()) : hash(hash), equal(equal) {}
+
+  size_type size() const noexcept{
+      return count;
+  }
+
+  bool empty() const noexcept{
+      return count == 0;
+  }
+
+  /// @brief Makes room for n keys without rehashing.
+  void reserve(size_type n){
+      size_type capacity = 16;
+      while(capacity * 3 < n * 4) capacity *= 2;
+      if(capacity > slots.size()) rehash(capacity);
+  }
+
+  /// @brief Returns a pointer to the value stored for key, or nullptr.
+  Value* find(const Key& key) noexcept{
+      if(count == 0) return nullptr;
+      for(size_type i = home(key);; i = (i + 1) & mask()){
+          if(!slots[i].used) return nullptr;
+          if(equal(slots[i].key, key)) return &slots[i].value;
+      }
+  }
+
+  const Value* find(const Key& key) const noexcept{
+      return const_cast<Hash_index*>(this)->find(key);
+  }
+
+  /// @brief Inserts key with value if key is not present yet.
+  /// @return false if key was already present; its value is left unchanged.
+  bool insert(const Key& key, const Value& value){
+      if((count + 1) * 4 > slots.size() * 3) rehash(slots.empty() ? 16 : slots.size() * 2);
+      size_type i = home(key);
+      for(; slots[i].used; i = (i + 1) & mask()){
+          if(equal(slots[i].key, key)) return false;
+      }
+      slots[i].key = key;
+      slots[i].value = value;
+      slots[i].used = true;
+      count++;
+      return true;
+  }
+
+  /// @brief Stores value for key, replacing the old value if there is one.
+  void assign(const Key& key, const Value& value){
+      if(Value* found = find(key)) *found = value;
+      else insert(key, value);
+  }
+
+  /// @brief Removes key.
+  /// @return false if key was not present.
+  bool erase(const Key& key){
+      if(count == 0) return false;
+      size_type i = home(key);
+      for(;; i = (i + 1) & mask()){
+          if(!slots[i].used) return false;
+          if(equal(slots[i].key, key)) break;
+      }
+      //Сдвигаем назад записи, чья цепочка проходит через освободившееся место.
+      for(size_type j = (i + 1) & mask(); slots[j].used; j = (j + 1) & mask()){
+          size_type k = home(slots[j].key);
+          bool between = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+          if(between) continue;
+          slots[i] = std::move(slots[j]);
+          i = j;
+      }
+      slots[i].used = false;
+      slots[i].key = Key();
+      slots[i].value = Value();
+      count--;
+      return true;
+  }
+
+  /// @brief Removes all keys. The table keeps its capacity.
+  void clear(){
+      for(Slot& slot : slots) slot = Slot();
+      count = 0;
+  }
+
+ private:
+  struct Slot {
+      Key key = Key();
+      Value value = Value();
+      bool used = false;
+  };
+
+  size_type mask() const noexcept{
+      return slots.size() - 1;
+  }
+
+  //std::hash для целых - тождественная функция, поэтому биты перемешиваются умножением Фибоначчи.
+  size_type home(const Key& key) const noexcept{
+      std::uint64_t h = static_cast<std::uint64_t>(hash(key)) * 0x9E3779B97F4A7C15ull;
+      return static_cast<size_type>(h >> 32 ^ h) & mask();
+  }
+
+  void rehash(size_type capacity){
+      std::vector<Slot> old(capacity);
+      old.swap(slots);
+      count = 0;
+      for(Slot& slot : old){
+          if(!slot.used) continue;
+          size_type i = home(slot.key);
+          while(slots[i].used) i = (i + 1) & mask();
+          slots[i] = std::move(slot);
+          count++;
+      }
+  }
+
+  std::vector<Slot> slots;
+  size_type count = 0;
+  Hash hash;
+  KeyEqual equal;
+};
+
+}  // namespace fefu_laboratory_two
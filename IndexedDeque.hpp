@@ -0,0 +1,145 @@
+#pragma once
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "Deque.hpp"
+#include "HashIndex.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек с хеш-индексом по ключу элемента: KeyFn извлекает ключ, Hash_index отображает ключ на узел.
+// Индекс обновляется при каждом push, pop, insert и erase, поэтому find, contains и erase_key - O(1)
+// в среднем вместо линейного прохода get_iter. Ключи уникальны: элемент с уже существующим ключом
+// не добавляется. Элементы доступны только для чтения, чтобы ключ не изменился мимо индекса.
+template <typename T, typename KeyFn, typename Hash = std::hash<std::decay_t<std::invoke_result_t<const KeyFn&, const T&>>>>
+class IndexedDeque {
+  static_assert(std::is_invocable<const KeyFn&, const T&>::value, "IndexedDeque needs a KeyFn callable as key_of(const T&)");
+
+ public:
+  using value_type = T;
+  using key_type = std::decay_t<std::invoke_result_t<const KeyFn&, const T&>>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+  using const_iterator = typename Deque<T>::const_iterator;
+
+  explicit IndexedDeque(KeyFn key_of = KeyFn()) : key_of(key_of) {}
+
+  IndexedDeque(const IndexedDeque&) = delete;
+  IndexedDeque& operator=(const IndexedDeque&) = delete;
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return deque.size();
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return deque.empty();
+  }
+
+  /// @brief Read-only access to the underlying deque, e.g. for iteration.
+  const Deque<T>& items() const noexcept{
+      return deque;
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  const_reference front() const{
+      return deque.front();
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  const_reference back() const{
+      return deque.back();
+  }
+
+  /// @brief Returns an iterator to the element with key, or items().end() if
+  /// there is none. O(1) on average.
+  const_iterator find(const key_type& key) const{
+      const_iterator pos;
+      Node<T>* const* found = index.find(key);
+      pos.cur = found == nullptr ? nullptr : *found;
+      pos.tail = &deque.last;
+      return pos;
+  }
+
+  /// @brief Checks if an element with key is present. O(1) on average.
+  bool contains(const key_type& key) const{
+      return index.find(key) != nullptr;
+  }
+
+  /// @brief Appends value unless its key is already present.
+  /// @return false if the key was already present.
+  bool push_back(const T& value){
+      if(contains(key_from(value))) return false;
+      deque.push_back(value);
+      index.insert(key_from(deque.last->value), deque.last);
+      return true;
+  }
+
+  /// @brief Prepends value unless its key is already present.
+  /// @return false if the key was already present.
+  bool push_front(const T& value){
+      if(contains(key_from(value))) return false;
+      deque.push_front(value);
+      index.insert(key_from(deque.first->value), deque.first);
+      return true;
+  }
+
+  /// @brief Inserts value before pos unless its key is already present; pos
+  /// with cur == nullptr inserts at the back.
+  /// @return false if the key was already present.
+  bool insert(const_iterator pos, const T& value){
+      if(contains(key_from(value))) return false;
+      auto it = deque.insert(pos, value);
+      index.insert(key_from(it.cur->value), it.cur);
+      return true;
+  }
+
+  /// @brief Removes the last element. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back(){
+      index.erase(key_from(deque.last->value));
+      deque.pop_back();
+  }
+
+  /// @brief Removes the first element. Calling pop_front on an empty
+  /// container is undefined.
+  void pop_front(){
+      index.erase(key_from(deque.first->value));
+      deque.pop_front();
+  }
+
+  /// @brief Removes the element at pos.
+  void erase(const_iterator pos){
+      index.erase(key_from(pos.cur->value));
+      deque.erase(pos);
+  }
+
+  /// @brief Removes the element with key. O(1) on average.
+  /// @return false if there was no such element.
+  bool erase_key(const key_type& key){
+      const_iterator pos = find(key);
+      if(pos.cur == nullptr) return false;
+      erase(pos);
+      return true;
+  }
+
+  /// @brief Erases all elements.
+  void clear(){
+      deque.clear();
+      index.clear();
+  }
+
+ private:
+  //Ключ через std::invoke, так что KeyFn может быть и указателем на член T.
+  decltype(auto) key_from(const T& value) const{
+      return std::invoke(key_of, value);
+  }
+
+  Deque<T> deque;
+  Hash_index<key_type, Node<T>*, Hash> index;
+  KeyFn key_of;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,250 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace fefu_laboratory_two {
+
+/// @brief Links embedded in an object so that it can sit in an
+/// IntrusiveDeque. Both are nullptr while the object is not in a deque and
+/// is not the only element of one.
+template <typename T>
+struct IntrusiveHook {
+    T* next = nullptr;
+    T* previous = nullptr;
+};
+
+// Интрузивный дек: объекты связываются через поле-крючок (hook) внутри самого T, так же как узлы Node
+// связаны через next/previous. Дек не владеет объектами и ничего не выделяет: push и pop только
+// переставляют указатели, а объект вырезается за O(1) по ссылке на него. Объект может одновременно
+// находиться в стольких деках, сколько у него крючков.
+template <typename T, IntrusiveHook<T> T::*Hook>
+class IntrusiveDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  template <typename U>
+  class basic_iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U*;
+    using reference = U&;
+
+    basic_iterator() = default;
+
+    //Из iterator можно получить const_iterator.
+    template <typename V>
+    basic_iterator(const basic_iterator<V>& other) : cur(other.cur), owner(other.owner) {}
+
+    reference operator*() const{
+        return *cur;
+    }
+
+    pointer operator->() const{
+        return cur;
+    }
+
+    basic_iterator& operator++(){
+        cur = (cur->*Hook).next;
+        return *this;
+    }
+
+    basic_iterator operator++(int){
+        basic_iterator temp(*this);
+        operator++();
+        return temp;
+    }
+
+    basic_iterator& operator--(){
+        cur = cur == nullptr ? owner->last : (cur->*Hook).previous;
+        return *this;
+    }
+
+    basic_iterator operator--(int){
+        basic_iterator temp(*this);
+        operator--();
+        return temp;
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b){
+        return a.cur == b.cur;
+    }
+
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b){
+        return a.cur != b.cur;
+    }
+
+   private:
+    friend class IntrusiveDeque;
+    template <typename V>
+    friend class basic_iterator;
+
+    basic_iterator(U* cur, const IntrusiveDeque* owner) : cur(cur), owner(owner) {}
+
+    U* cur = nullptr;
+    const IntrusiveDeque* owner = nullptr;
+  };
+
+  using iterator = basic_iterator<T>;
+  using const_iterator = basic_iterator<const T>;
+
+  IntrusiveDeque() = default;
+
+  IntrusiveDeque(const IntrusiveDeque&) = delete;
+  IntrusiveDeque& operator=(const IntrusiveDeque&) = delete;
+
+  /// @brief Takes over the objects linked into other.
+  IntrusiveDeque(IntrusiveDeque&& other) noexcept : first(other.first), last(other.last), _size(other._size){
+      other.first = nullptr;
+      other.last = nullptr;
+      other._size = 0;
+  }
+
+  /// @brief Unlinks every object. The objects themselves are not touched
+  /// otherwise.
+  ~IntrusiveDeque(){
+      clear();
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  iterator begin() noexcept{
+      return iterator(first, this);
+  }
+
+  const_iterator begin() const noexcept{
+      return const_iterator(first, this);
+  }
+
+  iterator end() noexcept{
+      return iterator(nullptr, this);
+  }
+
+  const_iterator end() const noexcept{
+      return const_iterator(nullptr, this);
+  }
+
+  /// @brief Returns an iterator to value, which must be in this deque. O(1).
+  iterator iterator_to(T& value) noexcept{
+      return iterator(&value, this);
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  reference front() noexcept{
+      return *first;
+  }
+
+  const_reference front() const noexcept{
+      return *first;
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  reference back() noexcept{
+      return *last;
+  }
+
+  const_reference back() const noexcept{
+      return *last;
+  }
+
+  /// @brief Links value at the end. value must not be in another deque
+  /// through the same hook.
+  void push_back(T& value) noexcept{
+      link(nullptr, &value);
+  }
+
+  /// @brief Links value at the beginning. value must not be in another deque
+  /// through the same hook.
+  void push_front(T& value) noexcept{
+      link(first, &value);
+  }
+
+  /// @brief Links value before pos.
+  /// @return Iterator pointing to value.
+  iterator insert(const_iterator pos, T& value) noexcept{
+      link(const_cast<T*>(pos.cur), &value);
+      return iterator(&value, this);
+  }
+
+  /// @brief Unlinks the last element. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back() noexcept{
+      unlink(last);
+  }
+
+  /// @brief Unlinks the first element. Calling pop_front on an empty
+  /// container is undefined.
+  void pop_front() noexcept{
+      unlink(first);
+  }
+
+  /// @brief Unlinks value, which must be in this deque. O(1).
+  void erase(T& value) noexcept{
+      unlink(&value);
+  }
+
+  /// @brief Unlinks the element at pos.
+  /// @return Iterator following the removed element.
+  iterator erase(const_iterator pos) noexcept{
+      T* value = const_cast<T*>(pos.cur);
+      T* next = (value->*Hook).next;
+      unlink(value);
+      return iterator(next, this);
+  }
+
+  /// @brief Unlinks all elements.
+  void clear() noexcept{
+      while(first != nullptr) unlink(first);
+  }
+
+  void swap(IntrusiveDeque& other) noexcept{
+      std::swap(first, other.first);
+      std::swap(last, other.last);
+      std::swap(_size, other._size);
+  }
+
+ private:
+  //Как Deque::link_chain для цепочки из одного объекта: before == nullptr - вставка в конец.
+  void link(T* before, T* value) noexcept{
+      IntrusiveHook<T>& hook = value->*Hook;
+      T* after = before == nullptr ? last : (before->*Hook).previous;
+      hook.previous = after;
+      hook.next = before;
+      if(after == nullptr) first = value;
+      else (after->*Hook).next = value;
+      if(before == nullptr) last = value;
+      else (before->*Hook).previous = value;
+      _size++;
+  }
+
+  //Как Deque::unlink_chain: соседи замыкаются друг на друга, крючок объекта обнуляется.
+  void unlink(T* value) noexcept{
+      IntrusiveHook<T>& hook = value->*Hook;
+      if(hook.previous == nullptr) first = hook.next;
+      else (hook.previous->*Hook).next = hook.next;
+      if(hook.next == nullptr) last = hook.previous;
+      else (hook.next->*Hook).previous = hook.previous;
+      hook.previous = nullptr;
+      hook.next = nullptr;
+      _size--;
+  }
+
+  T* first = nullptr;
+  T* last = nullptr;
+  size_type _size = 0;
+};
+
+}  // namespace fefu_laboratory_two
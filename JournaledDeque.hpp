@@ -0,0 +1,376 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек с журналом для переживания сбоев. Каждая операция push/pop дописывает короткую запись в буфер,
+// фоновый поток раз в commit_interval пишет накопленные записи одним write и одним fdatasync (group commit).
+// Когда журнал вырастает больше snapshot_bytes, состояние сохраняется снимком через Deque::save, а журнал обнуляется.
+// Снимок и журнал начинаются с номера эпохи: каждый снимок открывает новую эпоху, и журнал старой эпохи уже
+// содержится в снимке. При открытии загружается снимок и проигрываются записи журнала той же эпохи; недописанная
+// последняя запись отбрасывается.
+// Все операции потокобезопасны. Только для тривиально копируемых T.
+template <typename T>
+class JournaledDeque {
+  static_assert(std::is_trivially_copyable<T>::value, "JournaledDeque needs a trivially copyable T");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  /// @brief Opens the journal at path (files path + ".log" and path +
+  /// ".snap"), recovering the deque from them if they exist.
+  /// @param path prefix of the journal files
+  /// @param commit_interval how long the committer collects records before
+  /// one write + fdatasync
+  /// @param wait_for_commit if true, every mutation returns only after its
+  /// record is on disk; concurrent mutations share one fdatasync
+  /// @param snapshot_bytes log size after which a snapshot replaces the log
+  /// @throw std::system_error if the files cannot be opened or read
+  /// @throw std::runtime_error if the log does not match the snapshot
+  explicit JournaledDeque(const std::string& path,
+                          std::chrono::microseconds commit_interval = std::chrono::microseconds(1000),
+                          bool wait_for_commit = true, size_type snapshot_bytes = 64u << 20)
+      : log_path(path + ".log"), snapshot_path(path + ".snap"), commit_interval(commit_interval),
+        wait_for_commit(wait_for_commit), snapshot_bytes(snapshot_bytes){
+      try{
+          recover();
+      }
+      catch(...){
+          if(log_fd >= 0) ::close(log_fd);
+          throw;
+      }
+      committer = std::thread(&JournaledDeque::commit_loop, this);
+  }
+
+  JournaledDeque(const JournaledDeque&) = delete;
+  JournaledDeque& operator=(const JournaledDeque&) = delete;
+
+  /// @brief Commits the outstanding records and closes the journal.
+  ~JournaledDeque(){
+      {
+          std::lock_guard<std::mutex> guard(lock);
+          stopping = true;
+      }
+      wake_committer.notify_one();
+      committer.join();
+      ::close(log_fd);
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const{
+      std::lock_guard<std::mutex> guard(lock);
+      return deque.size();
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const{
+      std::lock_guard<std::mutex> guard(lock);
+      return deque.empty();
+  }
+
+  /// @brief Returns a copy of the first element. Calling front on an empty
+  /// container is undefined.
+  value_type front() const{
+      std::lock_guard<std::mutex> guard(lock);
+      return deque.front();
+  }
+
+  /// @brief Returns a copy of the last element. Calling back on an empty
+  /// container is undefined.
+  value_type back() const{
+      std::lock_guard<std::mutex> guard(lock);
+      return deque.back();
+  }
+
+  /// @brief Appends value to the end and journals it.
+  void push_back(const T& value){
+      mutate(op_push_back, &value);
+  }
+
+  /// @brief Prepends value to the beginning and journals it.
+  void push_front(const T& value){
+      mutate(op_push_front, &value);
+  }
+
+  /// @brief Removes the last element and journals it. Calling pop_back on an
+  /// empty container is undefined.
+  void pop_back(){
+      mutate(op_pop_back, nullptr);
+  }
+
+  /// @brief Removes the first element and journals it. Calling pop_front on
+  /// an empty container is undefined.
+  void pop_front(){
+      mutate(op_pop_front, nullptr);
+  }
+
+  /// @brief Blocks until every mutation made so far is on disk.
+  /// @throw std::system_error if the committer failed to write the log
+  void sync(){
+      std::unique_lock<std::mutex> guard(lock);
+      wait_durable(guard, appended);
+  }
+
+  /// @brief Writes a snapshot of the current state and empties the log.
+  /// Mutations are blocked while the snapshot is written.
+  /// @throw std::system_error if the snapshot cannot be written
+  void checkpoint(){
+      std::lock_guard<std::mutex> io_guard(io_lock);
+      std::lock_guard<std::mutex> guard(lock);
+      replace_log_with_snapshot();
+  }
+
+ private:
+  enum : unsigned char { op_push_back = 1, op_push_front = 2, op_pop_back = 3, op_pop_front = 4 };
+
+  using epoch_type = std::uint64_t;
+
+  void mutate(unsigned char op, const T* value){
+      std::unique_lock<std::mutex> guard(lock);
+      if(failure) throw std::system_error(failure, std::generic_category(), "JournaledDeque: log write failed");
+      apply(op, value);
+      pending.push_back(static_cast<char>(op));
+      if(value != nullptr){
+          const char* bytes = reinterpret_cast<const char*>(value);
+          pending.insert(pending.end(), bytes, bytes + sizeof(value_type));
+      }
+      std::uint64_t seq = ++appended;
+      if(wait_for_commit) wait_durable(guard, seq);
+  }
+
+  void apply(unsigned char op, const T* value){
+      switch(op){
+          case op_push_back: deque.push_back(*value); break;
+          case op_push_front: deque.push_front(*value); break;
+          case op_pop_back: deque.pop_back(); break;
+          case op_pop_front: deque.pop_front(); break;
+      }
+  }
+
+  void wait_durable(std::unique_lock<std::mutex>& guard, std::uint64_t seq){
+      committed.wait(guard, [&]{ return durable >= seq || failure != 0; });
+      if(durable < seq) throw std::system_error(failure, std::generic_category(), "JournaledDeque: log write failed");
+  }
+
+  //Фоновый поток: раз в commit_interval забирает накопленные записи и делает один write и один fdatasync.
+  //Ждет он без io_lock, чтобы checkpoint не простаивал; io_lock берется перед lock только на время записи,
+  //а за это время checkpoint мог уже забрать pending в снимок.
+  void commit_loop(){
+      for(;;){
+          std::unique_lock<std::mutex> guard(lock);
+          wake_committer.wait_for(guard, commit_interval, [&]{ return stopping; });
+          if(pending.empty()){
+              if(stopping) return;
+              continue;
+          }
+          guard.unlock();
+          std::unique_lock<std::mutex> io_guard(io_lock);
+          guard.lock();
+          if(pending.empty()) continue;
+          std::vector<char> batch;
+          batch.swap(pending);
+          std::uint64_t seq = appended;
+          guard.unlock();
+          int error = write_log(batch);
+          guard.lock();
+          if(error != 0){
+              failure = error;
+          }
+          else{
+              durable = seq;
+              log_bytes += batch.size();
+          }
+          committed.notify_all();
+          if(error == 0 && log_bytes >= snapshot_bytes){
+              try{
+                  replace_log_with_snapshot();
+              }
+              catch(const std::system_error& e){
+                  failure = e.code().value();
+                  committed.notify_all();
+              }
+              //Исключение из потока committer вызвало бы std::terminate, поэтому любая другая ошибка снимка
+              //(например, runtime_error из Deque::save) тоже превращается в отказ журнала.
+              catch(const std::exception&){
+                  failure = EIO;
+                  committed.notify_all();
+              }
+          }
+          if(stopping && pending.empty()) return;
+      }
+  }
+
+  int write_log(const std::vector<char>& batch){
+      const char* src = batch.data();
+      size_type bytes = batch.size();
+      while(bytes > 0){
+          ssize_t n = ::write(log_fd, src, bytes);
+          if(n < 0 && errno == EINTR) continue;
+          if(n < 0) return errno;
+          src += n;
+          bytes -= static_cast<size_type>(n);
+      }
+      if(::fdatasync(log_fd) != 0) return errno;
+      return 0;
+  }
+
+  //Снимок содержит все примененные операции, в том числе еще не записанные в журнал, поэтому после него
+  //буфер pending отбрасывается, а все операции считаются сохраненными. Вызывается с захваченными io_lock и lock.
+  void replace_log_with_snapshot(){
+      write_snapshot();
+      pending.clear();
+      durable = appended;
+      log_bytes = 0;
+      committed.notify_all();
+  }
+
+  //Снимок следующей эпохи пишется во временный файл, fsync, rename поверх старого, и только потом журнал
+  //начинается заново с новой эпохой. Если сбой случится между rename и обнулением, старый журнал останется
+  //со старой эпохой, и recover его пропустит. Вызывается с захваченными io_lock и lock.
+  void write_snapshot(){
+      epoch_type next = epoch + 1;
+      std::string tmp = snapshot_path + ".tmp";
+      {
+          std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+          if(!out) throw std::system_error(errno, std::generic_category(), "JournaledDeque: open " + tmp);
+          out.write(reinterpret_cast<const char*>(&next), sizeof(next));
+          deque.save(out);
+          out.flush();
+          if(!out) throw std::system_error(EIO, std::generic_category(), "JournaledDeque: write " + tmp);
+      }
+      int fd = ::open(tmp.c_str(), O_RDONLY);
+      if(fd < 0 || ::fsync(fd) != 0){
+          int error = errno;
+          if(fd >= 0) ::close(fd);
+          throw std::system_error(error, std::generic_category(), "JournaledDeque: fsync " + tmp);
+      }
+      ::close(fd);
+      if(std::rename(tmp.c_str(), snapshot_path.c_str()) != 0){
+          throw std::system_error(errno, std::generic_category(), "JournaledDeque: rename " + tmp);
+      }
+      sync_directory();
+      epoch = next;
+      reset_log();
+  }
+
+  //rename становится долговечным только после fsync каталога: иначе после сбоя питания на диске мог бы
+  //оказаться старый снимок рядом с уже обнуленным журналом новой эпохи.
+  void sync_directory(){
+      std::string::size_type slash = snapshot_path.rfind('/');
+      std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : snapshot_path.substr(0, slash);
+      int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+      if(fd < 0 || ::fsync(fd) != 0){
+          int error = errno;
+          if(fd >= 0) ::close(fd);
+          throw std::system_error(error, std::generic_category(), "JournaledDeque: fsync " + dir);
+      }
+      ::close(fd);
+  }
+
+  //Обнуляет журнал и записывает в его начало текущую эпоху. Если это не удалось, новые записи попали бы
+  //в журнал старой эпохи и пропали бы при восстановлении, поэтому дальнейшие операции отказывают.
+  void reset_log(){
+      int error = ::ftruncate(log_fd, 0) != 0 ? errno : 0;
+      if(error == 0){
+          std::vector<char> header(reinterpret_cast<const char*>(&epoch),
+                                   reinterpret_cast<const char*>(&epoch) + sizeof(epoch));
+          error = write_log(header);
+      }
+      if(error != 0){
+          failure = error;
+          throw std::system_error(error, std::generic_category(), "JournaledDeque: reset " + log_path);
+      }
+  }
+
+  //Загружает снимок, проигрывает журнал той же эпохи и обрезает недописанный хвост. Журнал старой эпохи
+  //(сбой после rename снимка) или без целого заголовка отбрасывается: его записи уже в снимке.
+  void recover(){
+      std::ifstream snapshot(snapshot_path, std::ios::binary);
+      if(snapshot){
+          if(!snapshot.read(reinterpret_cast<char*>(&epoch), sizeof(epoch))){
+              throw std::runtime_error("JournaledDeque: truncated snapshot " + snapshot_path);
+          }
+          deque.load(snapshot);
+      }
+      log_fd = ::open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+      if(log_fd < 0) throw std::system_error(errno, std::generic_category(), "JournaledDeque: open " + log_path);
+      std::vector<char> log;
+      char buffer[65536];
+      for(;;){
+          ssize_t n = ::read(log_fd, buffer, sizeof(buffer));
+          if(n < 0 && errno == EINTR) continue;
+          if(n < 0) throw std::system_error(errno, std::generic_category(), "JournaledDeque: read " + log_path);
+          if(n == 0) break;
+          log.insert(log.end(), buffer, buffer + n);
+      }
+      epoch_type log_epoch = 0;
+      if(log.size() >= sizeof(epoch_type)) std::memcpy(&log_epoch, log.data(), sizeof(epoch_type));
+      if(log.size() < sizeof(epoch_type) || log_epoch < epoch){
+          reset_log();
+          log_bytes = 0;
+          return;
+      }
+      if(log_epoch > epoch) throw std::runtime_error("JournaledDeque: " + log_path + " is newer than the snapshot");
+      size_type pos = sizeof(epoch_type);
+      while(pos < log.size()){
+          unsigned char op = static_cast<unsigned char>(log[pos]);
+          bool has_value = op == op_push_back || op == op_push_front;
+          if(op < op_push_back || op > op_pop_front) break;
+          if(has_value && pos + 1 + sizeof(value_type) > log.size()) break;
+          if(!has_value && deque.empty()){
+              throw std::runtime_error("JournaledDeque: " + log_path + " pops an empty deque");
+          }
+          T value;
+          if(has_value) std::memcpy(&value, log.data() + pos + 1, sizeof(value_type));
+          apply(op, has_value ? &value : nullptr);
+          pos += 1 + (has_value ? sizeof(value_type) : 0);
+      }
+      if(pos < log.size() && ::ftruncate(log_fd, static_cast<off_t>(pos)) != 0){
+          throw std::system_error(errno, std::generic_category(), "JournaledDeque: ftruncate " + log_path);
+      }
+      log_bytes = pos - sizeof(epoch_type);
+  }
+
+  std::string log_path;
+  std::string snapshot_path;
+  std::chrono::microseconds commit_interval;
+  bool wait_for_commit;
+  size_type snapshot_bytes;
+
+  Deque<T> deque;
+  epoch_type epoch = 0; //Эпоха последнего снимка, ею же помечен текущий журнал.
+  int log_fd = -1;
+  mutable std::mutex lock; //Защищает deque, pending и счетчики.
+  std::mutex io_lock; //Захватывается раньше lock, сериализует запись журнала и снимка.
+  std::condition_variable wake_committer;
+  std::condition_variable committed;
+  std::vector<char> pending;
+  std::uint64_t appended = 0;
+  std::uint64_t durable = 0;
+  size_type log_bytes = 0;
+  int failure = 0;
+  bool stopping = false;
+  std::thread committer;
+};
+
+}  // namespace fefu_laboratory_two
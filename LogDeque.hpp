@@ -0,0 +1,230 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Дек как журнал в памяти: каждый элемент при push_back получает 64-битный номер (seq), который не меняется
+// при удалении элементов из начала. Элементы лежат в блоках по block_elements штук, все блоки, кроме крайних,
+// полные, поэтому at_seq - O(1). Читатели - курсоры Cursor, каждый помнит свой номер. Когда все
+// зарегистрированные курсоры прошли начало журнала, оно отбрасывается автоматически, целыми блоками.
+template <typename T>
+class LogDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+
+  // Независимый читатель журнала. Регистрируется в конструкторе и снимается с регистрации в деструкторе;
+  // журнал не отбрасывает элементы, до которых курсор еще не дошел. Курсор должен быть уничтожен
+  // раньше журнала.
+  class Cursor {
+   public:
+    /// @brief Registers a cursor positioned at the first element of log.
+    explicit Cursor(LogDeque& log) : Cursor(log, log.first_seq()) {}
+
+    /// @brief Registers a cursor positioned at seq, clamped to the retained
+    /// range of log.
+    Cursor(LogDeque& log, std::uint64_t seq) : log(log), seq(log.clamp(seq)){
+        log.cursors.push_back(this);
+        log.release_head();
+    }
+
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+
+    ~Cursor(){
+        log.cursors.erase(std::find(log.cursors.begin(), log.cursors.end(), this));
+        log.release_head();
+    }
+
+    /// @brief Sequence number of the next element this cursor reads.
+    std::uint64_t position() const noexcept{
+        return seq;
+    }
+
+    /// @brief Number of elements between the cursor and the end of the log.
+    size_type available() const noexcept{
+        return static_cast<size_type>(log.end_seq() - seq);
+    }
+
+    bool has_next() const noexcept{
+        return seq < log.end_seq();
+    }
+
+    /// @brief Returns the element at the cursor without advancing; reading
+    /// in place needs no copy. The reference stays valid until the cursor
+    /// moves. Calling peek when has_next() is false is undefined.
+    const_reference peek() const{
+        return log.element(seq);
+    }
+
+    /// @brief Returns a copy of the element at the cursor and advances.
+    /// Calling next when has_next() is false is undefined.
+    value_type next(){
+        value_type value = log.element(seq);
+        advance(1);
+        return value;
+    }
+
+    /// @brief Moves the cursor forward by count elements (to the end at most).
+    void advance(size_type count){
+        seek(seq + std::min<std::uint64_t>(count, log.end_seq() - seq));
+    }
+
+    /// @brief Moves the cursor to seq, clamped to the retained range.
+    void seek(std::uint64_t target){
+        std::uint64_t old = seq;
+        seq = log.clamp(target);
+        if(old == log.first_seq()) log.release_head();
+    }
+
+   private:
+    friend class LogDeque;
+
+    LogDeque& log;
+    std::uint64_t seq;
+  };
+
+  /// @brief Constructs an empty log.
+  /// @param block_elements number of elements in one block
+  /// @param first_seq sequence number the first pushed element gets
+  explicit LogDeque(size_type block_elements = 1024, std::uint64_t first_seq = 0)
+      : block_elements(block_elements ? block_elements : 1), head_seq(first_seq) {}
+
+  LogDeque(const LogDeque&) = delete;
+  LogDeque& operator=(const LogDeque&) = delete;
+
+  /// @brief Returns the number of retained elements
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if no elements are retained
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Sequence number of the first retained element.
+  std::uint64_t first_seq() const noexcept{
+      return head_seq;
+  }
+
+  /// @brief Sequence number the next pushed element will get.
+  std::uint64_t end_seq() const noexcept{
+      return head_seq + _size;
+  }
+
+  /// @brief Checks if seq is still retained.
+  bool contains_seq(std::uint64_t seq) const noexcept{
+      return seq >= head_seq && seq < end_seq();
+  }
+
+  /// @brief Returns the element with sequence number seq. O(1).
+  /// @throw std::out_of_range if seq was truncated or not pushed yet
+  const_reference at_seq(std::uint64_t seq) const{
+      if(!contains_seq(seq)) throw std::out_of_range("sequence number out of range");
+      return element(seq);
+  }
+
+  /// @brief Appends value.
+  /// @return Sequence number of the new element.
+  std::uint64_t push_back(const T& value){
+      if(head == blocks.size() || blocks.back()->hi == block_elements){
+          blocks.push_back(new_block());
+      }
+      Block& block = *blocks.back();
+      block.items[block.hi++] = value;
+      _size++;
+      return end_seq() - 1;
+  }
+
+  /// @brief Drops the first element. Cursors that have not read it yet move
+  /// on to the next one. Calling pop_front on an empty log is undefined.
+  void pop_front(){
+      truncate(head_seq + 1);
+  }
+
+  /// @brief Drops every element before seq. Cursors behind seq move to it.
+  void truncate(std::uint64_t seq){
+      seq = std::min(seq, end_seq());
+      for(Cursor* cursor : cursors){
+          if(cursor->seq < seq) cursor->seq = seq;
+      }
+      drop_until(seq);
+  }
+
+ private:
+  //Занятые позиции блока - [lo, hi).
+  struct Block {
+      std::unique_ptr<T[]> items;
+      size_type lo = 0;
+      size_type hi = 0;
+  };
+
+  std::uint64_t clamp(std::uint64_t seq) const noexcept{
+      return std::max(head_seq, std::min(seq, end_seq()));
+  }
+
+  const_reference element(std::uint64_t seq) const{
+      size_type pos = blocks[head]->lo + static_cast<size_type>(seq - head_seq);
+      const Block& block = *blocks[head + pos / block_elements];
+      return block.items[pos % block_elements];
+  }
+
+  //Начало журнала отбрасывается до самого отстающего курсора. Без курсоров ничего не отбрасывается.
+  void release_head(){
+      if(cursors.empty()) return;
+      std::uint64_t slowest = cursors.front()->seq;
+      for(Cursor* cursor : cursors) slowest = std::min(slowest, cursor->seq);
+      drop_until(slowest);
+  }
+
+  void drop_until(std::uint64_t seq){
+      while(head_seq < seq){
+          Block& block = *blocks[head];
+          size_type count = static_cast<size_type>(std::min<std::uint64_t>(block.hi - block.lo, seq - head_seq));
+          block.lo += count;
+          head_seq += count;
+          _size -= count;
+          if(block.lo == block.hi){
+              spare = std::move(blocks[head]);
+              head++;
+          }
+      }
+      //Освободившиеся места каталога перед head забираем, когда их больше половины.
+      if(head == blocks.size()){
+          blocks.clear();
+          head = 0;
+      }
+      else if(head > blocks.size() / 2){
+          blocks.erase(blocks.begin(), blocks.begin() + head);
+          head = 0;
+      }
+  }
+
+  //Один освободившийся блок держим про запас, чтобы журнал в установившемся режиме не выделял память.
+  std::unique_ptr<Block> new_block(){
+      std::unique_ptr<Block> block = std::move(spare);
+      if(!block){
+          block.reset(new Block);
+          block->items.reset(new T[block_elements]);
+      }
+      block->lo = 0;
+      block->hi = 0;
+      return block;
+  }
+
+  std::vector<std::unique_ptr<Block>> blocks; //Занята часть [head, blocks.size()).
+  std::unique_ptr<Block> spare;
+  std::vector<Cursor*> cursors;
+  size_type head = 0;
+  size_type block_elements;
+  std::uint64_t head_seq;
+  size_type _size = 0;
+};
+
+}  // namespace fefu_laboratory_two
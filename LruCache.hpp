@@ -0,0 +1,180 @@
+#pragma once
+#include <functional>
+
+#include "Deque.hpp"
+#include "HashIndex.hpp"
+
+namespace fefu_laboratory_two {
+
+// Кэш с вытеснением давно не использованных записей (LRU). Записи - узлы Deque от недавних к давним,
+// Hash_index отображает ключ на узел. Обращение к записи переносит ее узел в начало перестановкой
+// указателей (splice), а новая запись при полном кэше занимает узел вытесненной, так что get, put
+// и вытеснение - O(1) и после прогрева не выделяют память.
+// При protected_capacity > 0 кэш сегментированный (SLRU): новые записи попадают в испытательный сегмент,
+// повторно использованные - в защищенный, вытесняется конец испытательного сегмента. Так разовые
+// обращения (например, полный проход по данным) не вымывают часто используемые записи.
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class LruCache {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = std::size_t;
+
+  /// @brief Constructs an empty cache.
+  /// @param capacity maximum number of entries
+  /// @param protected_capacity how many of them the protected segment may
+  /// hold; 0 gives a plain LRU cache
+  explicit LruCache(size_type capacity, size_type protected_capacity = 0)
+      : max_size(capacity ? capacity : 1),
+        protected_capacity(protected_capacity < max_size ? protected_capacity : max_size - 1){
+      index.reserve(max_size);
+  }
+
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  /// @brief Returns the number of cached entries
+  size_type size() const noexcept{
+      return probation.size() + protected_segment.size();
+  }
+
+  /// @brief Checks if the cache has no entries
+  bool empty() const noexcept{
+      return size() == 0;
+  }
+
+  size_type capacity() const noexcept{
+      return max_size;
+  }
+
+  /// @brief Number of get() calls that found their key.
+  size_type hits() const noexcept{
+      return hit_count;
+  }
+
+  /// @brief Number of get() calls that did not find their key.
+  size_type misses() const noexcept{
+      return miss_count;
+  }
+
+  /// @brief hits() / (hits() + misses()), 0 before the first get().
+  double hit_rate() const noexcept{
+      size_type total = hit_count + miss_count;
+      return total == 0 ? 0.0 : static_cast<double>(hit_count) / static_cast<double>(total);
+  }
+
+  /// @brief Looks key up and marks the entry as just used.
+  /// @return Pointer to the cached value, valid until the entry is evicted
+  /// or erased, or nullptr on a miss.
+  V* get(const K& key){
+      Node<Entry>** found = index.find(key);
+      if(found == nullptr){
+          miss_count++;
+          return nullptr;
+      }
+      hit_count++;
+      promote(*found);
+      return &(*found)->value.value;
+  }
+
+  /// @brief Checks if key is cached without marking it as used.
+  bool contains(const K& key) const{
+      return index.find(key) != nullptr;
+  }
+
+  /// @brief Marks key as just used without counting a hit.
+  /// @return false if key is not cached.
+  bool touch(const K& key){
+      Node<Entry>** found = index.find(key);
+      if(found == nullptr) return false;
+      promote(*found);
+      return true;
+  }
+
+  /// @brief Stores value for key and marks it as just used. When the cache is
+  /// full the least recently used entry is evicted and its node reused.
+  void put(const K& key, const V& value){
+      if(Node<Entry>** found = index.find(key)){
+          (*found)->value.value = value;
+          promote(*found);
+          return;
+      }
+      if(size() < max_size){
+          probation.push_front(Entry{key, value, false});
+          index.insert(key, probation.first);
+          return;
+      }
+      Deque<Entry>& victims = probation.empty() ? protected_segment : probation;
+      Node<Entry>* node = victims.last;
+      index.erase(node->value.key);
+      node->value.key = key;
+      node->value.value = value;
+      move_to_front(node, victims, probation);
+      node->value.hot = false;
+      index.insert(key, node);
+  }
+
+  /// @brief Removes key from the cache.
+  /// @return false if key was not cached.
+  bool erase(const K& key){
+      Node<Entry>** found = index.find(key);
+      if(found == nullptr) return false;
+      Node<Entry>* node = *found;
+      index.erase(key);
+      Deque<Entry>& segment = node->value.hot ? protected_segment : probation;
+      typename Deque<Entry>::const_iterator pos;
+      pos.cur = node;
+      segment.erase(pos);
+      return true;
+  }
+
+  /// @brief Removes every entry. Statistics are kept.
+  void clear(){
+      probation.clear();
+      protected_segment.clear();
+      index.clear();
+  }
+
+ private:
+  struct Entry {
+      K key;
+      V value;
+      bool hot; //Запись в защищенном сегменте.
+  };
+
+  //Переносит узел в начало сегмента to; splice одного узла - O(1) и без выделения памяти.
+  static void move_to_front(Node<Entry>* node, Deque<Entry>& from, Deque<Entry>& to){
+      if(&from == &to && to.first == node) return;
+      typename Deque<Entry>::const_iterator pos, first, last;
+      pos.cur = to.first;
+      first.cur = node;
+      last.cur = node->next;
+      to.splice(pos, from, first, last);
+  }
+
+  //Использованная запись идет в начало защищенного сегмента (в SLRU) или просто в начало (в LRU).
+  //Лишняя запись защищенного сегмента возвращается в начало испытательного.
+  void promote(Node<Entry>* node){
+      if(protected_capacity == 0){
+          move_to_front(node, probation, probation);
+          return;
+      }
+      move_to_front(node, node->value.hot ? protected_segment : probation, protected_segment);
+      node->value.hot = true;
+      if(protected_segment.size() > protected_capacity){
+          Node<Entry>* demoted = protected_segment.last;
+          move_to_front(demoted, protected_segment, probation);
+          demoted->value.hot = false;
+      }
+  }
+
+  Deque<Entry> probation; //От недавних к давним; в обычном LRU все записи здесь.
+  Deque<Entry> protected_segment;
+  Hash_index<K, Node<Entry>*, Hash, KeyEqual> index;
+  size_type max_size;
+  size_type protected_capacity;
+  size_type hit_count = 0;
+  size_type miss_count = 0;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,272 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fefu_laboratory_two {
+
+// Дек, элементы которого лежат в отображенном в память файле (mmap). Подкачкой страниц занимается ОС,
+// поэтому очередь может быть больше оперативной памяти, а после перезапуска файл просто открывается заново.
+// Внутри файла - заголовок и кольцевой буфер на capacity элементов, при заполнении файл растет вдвое.
+// Только для тривиально копируемых T: элементы хранятся байтами и переживают перезапуск процесса.
+template <typename T>
+class MappedDeque {
+  static_assert(std::is_trivially_copyable<T>::value, "MappedDeque needs a trivially copyable T");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  /// @brief Opens the deque stored in the file at path, or creates the file
+  /// if it does not exist.
+  /// @param path file holding the deque
+  /// @param initial_capacity number of elements a new file has room for
+  /// @throw std::system_error if the file cannot be opened, resized or mapped
+  /// @throw std::runtime_error if an existing file is not a deque of T
+  explicit MappedDeque(const std::string& path, size_type initial_capacity = 1024){
+      fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+      if(fd < 0) throw std::system_error(errno, std::generic_category(), "MappedDeque: open " + path);
+      struct stat st;
+      if(::fstat(fd, &st) != 0) fail("MappedDeque: fstat");
+      if(st.st_size == 0){
+          size_type capacity = initial_capacity ? initial_capacity : 1;
+          resize_file(file_size(capacity));
+          map(file_size(capacity));
+          std::memcpy(header->magic, file_magic(), sizeof(header->magic));
+          header->version = file_version;
+          header->element_size = sizeof(value_type);
+          header->capacity = capacity;
+          header->head = 0;
+          header->size = 0;
+          return;
+      }
+      if(static_cast<std::uint64_t>(st.st_size) < sizeof(Header)) close_and_throw("MappedDeque: file is too short");
+      map(static_cast<size_type>(st.st_size));
+      if(std::memcmp(header->magic, file_magic(), sizeof(header->magic)) != 0) close_and_throw("MappedDeque: not a deque file");
+      if(header->version != file_version) close_and_throw("MappedDeque: unsupported file version");
+      if(header->element_size != sizeof(value_type)) close_and_throw("MappedDeque: element size mismatch");
+      if(file_size(header->capacity) > mapped_bytes) close_and_throw("MappedDeque: file is truncated");
+  }
+
+  MappedDeque(const MappedDeque&) = delete;
+  MappedDeque& operator=(const MappedDeque&) = delete;
+
+  /// @brief Move constructor. other no longer refers to the file.
+  MappedDeque(MappedDeque&& other) noexcept
+      : fd(other.fd), base(other.base), mapped_bytes(other.mapped_bytes), header(other.header), data(other.data){
+      other.fd = -1;
+      other.base = nullptr;
+      other.header = nullptr;
+      other.data = nullptr;
+      other.mapped_bytes = 0;
+  }
+
+  /// @brief Unmaps and closes the file. The contents stay in the file; call
+  /// sync() first to be sure they reached the disk.
+  ~MappedDeque(){
+      if(base != nullptr) ::munmap(base, mapped_bytes);
+      if(fd >= 0) ::close(fd);
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return static_cast<size_type>(header->size);
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return header->size == 0;
+  }
+
+  /// @brief Number of elements the file has room for before it grows.
+  size_type capacity() const noexcept{
+      return static_cast<size_type>(header->capacity);
+  }
+
+  /// @brief Returns a reference to the element at pos. No bounds checking is
+  /// performed.
+  reference operator[](size_type pos){
+      return data[slot(pos)];
+  }
+
+  const_reference operator[](size_type pos) const{
+      return data[slot(pos)];
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  reference at(size_type pos){
+      if(pos >= size()) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  const_reference at(size_type pos) const{
+      if(pos >= size()) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  reference front(){
+      return data[header->head];
+  }
+
+  const_reference front() const{
+      return data[header->head];
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  reference back(){
+      return data[slot(size() - 1)];
+  }
+
+  const_reference back() const{
+      return data[slot(size() - 1)];
+  }
+
+  /// @brief Appends value to the end, growing the file if it is full.
+  /// @throw std::system_error if the file cannot grow
+  void push_back(const T& value){
+      if(header->size == header->capacity) grow();
+      data[slot(size())] = value;
+      header->size++;
+  }
+
+  /// @brief Prepends value to the beginning, growing the file if it is full.
+  /// @throw std::system_error if the file cannot grow
+  void push_front(const T& value){
+      if(header->size == header->capacity) grow();
+      std::uint64_t head = header->head == 0 ? header->capacity - 1 : header->head - 1;
+      data[head] = value;
+      header->head = head;
+      header->size++;
+  }
+
+  /// @brief Removes the last element. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back(){
+      header->size--;
+  }
+
+  /// @brief Removes the first element. Calling pop_front on an empty
+  /// container is undefined.
+  void pop_front(){
+      header->head = header->head + 1 == header->capacity ? 0 : header->head + 1;
+      header->size--;
+  }
+
+  /// @brief Erases all elements. The file keeps its size.
+  void clear() noexcept{
+      header->head = 0;
+      header->size = 0;
+  }
+
+  /// @brief Checkpoint: blocks until all changes made so far are written to
+  /// the file.
+  /// @throw std::system_error if msync fails
+  void sync(){
+      if(::msync(base, mapped_bytes, MS_SYNC) != 0) throw std::system_error(errno, std::generic_category(), "MappedDeque: msync");
+  }
+
+ private:
+  struct Header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t element_size;
+      std::uint64_t capacity;
+      std::uint64_t head;
+      std::uint64_t size;
+  };
+
+  static const char* file_magic() noexcept{
+      return "FDQMAP1";
+  }
+
+  static constexpr std::uint32_t file_version = 1;
+  //Данные начинаются с отступом, кратным 64, чтобы элементы были выровнены.
+  static constexpr size_type data_offset = (sizeof(Header) + 63) / 64 * 64;
+
+  static size_type file_size(size_type capacity){
+      return data_offset + capacity * sizeof(value_type);
+  }
+
+  size_type slot(size_type pos) const noexcept{
+      size_type i = static_cast<size_type>(header->head) + pos;
+      return i >= header->capacity ? i - static_cast<size_type>(header->capacity) : i;
+  }
+
+  void map(size_type bytes){
+      void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED) fail("MappedDeque: mmap");
+      attach(p, bytes);
+  }
+
+  void attach(void* p, size_type bytes){
+      base = p;
+      mapped_bytes = bytes;
+      header = static_cast<Header*>(base);
+      data = reinterpret_cast<value_type*>(static_cast<char*>(base) + data_offset);
+  }
+
+  void resize_file(size_type bytes){
+      if(::ftruncate(fd, static_cast<off_t>(bytes)) != 0) fail("MappedDeque: ftruncate");
+  }
+
+  //Ошибки при росте не закрывают файл: старое отображение остается рабочим.
+  static void throw_errno(const char* what){
+      throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  //Файл растет вдвое. Если кольцо было разорвано, его начало [0, wrapped) переносится сразу за старый конец,
+  //и только после этого в заголовке меняется capacity, так что сбой посередине оставляет файл согласованным.
+  void grow(){
+      size_type old_capacity = capacity();
+      size_type new_capacity = old_capacity * 2;
+      if(::ftruncate(fd, static_cast<off_t>(file_size(new_capacity))) != 0) throw_errno("MappedDeque: ftruncate");
+      void* p = ::mmap(nullptr, file_size(new_capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED) throw_errno("MappedDeque: mmap");
+      ::munmap(base, mapped_bytes);
+      attach(p, file_size(new_capacity));
+      size_type end = static_cast<size_type>(header->head) + size();
+      if(end > old_capacity){
+          std::memcpy(data + old_capacity, data, (end - old_capacity) * sizeof(value_type));
+      }
+      header->capacity = new_capacity;
+  }
+
+  [[noreturn]] void fail(const char* what){
+      int error = errno;
+      if(base != nullptr) ::munmap(base, mapped_bytes);
+      ::close(fd);
+      base = nullptr;
+      fd = -1;
+      throw std::system_error(error, std::generic_category(), what);
+  }
+
+  [[noreturn]] void close_and_throw(const char* what){
+      ::munmap(base, mapped_bytes);
+      ::close(fd);
+      base = nullptr;
+      fd = -1;
+      throw std::runtime_error(what);
+  }
+
+  int fd = -1;
+  void* base = nullptr;
+  size_type mapped_bytes = 0;
+  Header* header = nullptr;
+  value_type* data = nullptr;
+};
+
+}  // namespace fefu_laboratory_two
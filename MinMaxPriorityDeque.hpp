@@ -0,0 +1,184 @@
+#pragma once
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Очередь с приоритетами с двух сторон: наименьший и наибольший элемент доступны за O(1), вставка и
+// извлечение любого из них - O(log n). Внутри min-max куча в непрерывном массиве: на четных уровнях
+// (корень - уровень 0) элемент не больше всех своих потомков, на нечетных - не меньше.
+// Массив - std::vector, а не Deque: куча переходит от узла к родителю и потомкам по индексу, это нужно
+// делать за O(1), а operator[] у Deque проходит узлы и стоит O(n).
+template <typename T, typename Compare = std::less<T>>
+class MinMaxPriorityDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+
+  explicit MinMaxPriorityDeque(const Compare& compare = Compare()) : less(compare) {}
+
+  /// @brief Builds the heap from the elements of source in O(n).
+  template <typename Allocator, typename Policy>
+  explicit MinMaxPriorityDeque(const Deque<T, Allocator, Policy>& source, const Compare& compare = Compare()) : less(compare){
+      heap.reserve(source.size());
+      for(Node<T>* cur = source.first; cur != nullptr; cur = cur->next) heap.push_back(cur->value);
+      heapify();
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return heap.size();
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return heap.empty();
+  }
+
+  void reserve(size_type count){
+      heap.reserve(count);
+  }
+
+  void clear() noexcept{
+      heap.clear();
+  }
+
+  /// @brief Returns the smallest element. Calling min on an empty container
+  /// is undefined.
+  const_reference min() const{
+      return heap[0];
+  }
+
+  /// @brief Returns the largest element. Calling max on an empty container
+  /// is undefined.
+  const_reference max() const{
+      return heap[max_index()];
+  }
+
+  /// @brief Inserts value in O(log n).
+  void push(const T& value){
+      heap.push_back(value);
+      bubble_up(heap.size() - 1);
+  }
+
+  void push(T&& value){
+      heap.push_back(std::move(value));
+      bubble_up(heap.size() - 1);
+  }
+
+  /// @brief Inserts the elements of [first, last). A batch at least as large
+  /// as the container is merged by rebuilding the heap in O(n + k), smaller
+  /// batches are inserted one by one.
+  template <class InputIt>
+  void push(InputIt first, InputIt last){
+      size_type before = heap.size();
+      heap.insert(heap.end(), first, last);
+      if(heap.size() - before >= before){
+          heapify();
+          return;
+      }
+      for(size_type i = before; i < heap.size(); i++) bubble_up(i);
+  }
+
+  /// @brief Removes the smallest element. Calling pop_min on an empty
+  /// container is undefined.
+  void pop_min(){
+      remove(0);
+  }
+
+  /// @brief Removes the largest element. Calling pop_max on an empty
+  /// container is undefined.
+  void pop_max(){
+      remove(max_index());
+  }
+
+ private:
+  static bool on_min_level(size_type i) noexcept{
+      unsigned level = 0;
+      for(size_type n = i + 1; n > 1; n >>= 1) level++;
+      return level % 2 == 0;
+  }
+
+  static size_type parent(size_type i) noexcept{
+      return (i - 1) / 2;
+  }
+
+  size_type max_index() const noexcept{
+      if(heap.size() < 3) return heap.size() - 1;
+      return less(heap[1], heap[2]) ? 2 : 1;
+  }
+
+  //Последний элемент встает на место удаляемого и спускается вниз.
+  void remove(size_type i){
+      heap[i] = std::move(heap.back());
+      heap.pop_back();
+      if(i < heap.size()) trickle_down(i);
+  }
+
+  void heapify(){
+      for(size_type i = heap.size() / 2; i-- > 0;) trickle_down(i);
+  }
+
+  void bubble_up(size_type i){
+      if(i == 0) return;
+      size_type p = parent(i);
+      if(on_min_level(i)){
+          if(less(heap[p], heap[i])){
+              std::swap(heap[i], heap[p]);
+              bubble_up_grandparents(p, true);
+          }
+          else{
+              bubble_up_grandparents(i, false);
+          }
+      }
+      else{
+          if(less(heap[i], heap[p])){
+              std::swap(heap[i], heap[p]);
+              bubble_up_grandparents(p, false);
+          }
+          else{
+              bubble_up_grandparents(i, true);
+          }
+      }
+  }
+
+  //Подъем по уровням своего типа: у максимальных (max_level) элемент поднимается, пока он больше деда.
+  void bubble_up_grandparents(size_type i, bool max_level){
+      while(i >= 3){
+          size_type g = parent(parent(i));
+          if(!(max_level ? less(heap[g], heap[i]) : less(heap[i], heap[g]))) break;
+          std::swap(heap[i], heap[g]);
+          i = g;
+      }
+  }
+
+  //Спуск: среди детей и внуков берется наименьший (на минимальном уровне) или наибольший элемент.
+  void trickle_down(size_type i){
+      bool max_level = !on_min_level(i);
+      auto before = [&](size_type a, size_type b){ return max_level ? less(heap[b], heap[a]) : less(heap[a], heap[b]); };
+      for(;;){
+          size_type child = 2 * i + 1;
+          if(child >= heap.size()) return;
+          size_type m = child;
+          size_type candidates[] = {child + 1, 2 * child + 1, 2 * child + 2, 2 * child + 3, 2 * child + 4};
+          for(size_type c : candidates){
+              if(c < heap.size() && before(c, m)) m = c;
+          }
+          if(!before(m, i)) return;
+          std::swap(heap[m], heap[i]);
+          if(m <= child + 1) return;
+          if(before(parent(m), m)) std::swap(heap[m], heap[parent(m)]);
+          i = m;
+      }
+  }
+
+  std::vector<T> heap;
+  Compare less;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,280 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Дек флагов и маленьких чисел, упакованных по Bits бит (1, 2, 4 или 8) в 64-битные слова.
+// Слова образуют кольцевой буфер из capacity дорожек (lane), который растет вдвое при заполнении.
+// Элемент читается и пишется через прокси-ссылку, а count и fill обрабатывают слово целиком:
+// дорожки, равные значению, находятся исключающим или с размноженным значением и popcount.
+template <unsigned Bits>
+class PackedDeque {
+  static_assert(Bits == 1 || Bits == 2 || Bits == 4 || Bits == 8, "PackedDeque supports 1, 2, 4 or 8 bit lanes");
+
+ public:
+  using value_type = typename std::conditional<Bits == 1, bool, std::uint8_t>::type;
+  using size_type = std::size_t;
+
+  //Прокси на одну дорожку, как у std::vector<bool>.
+  class reference {
+   public:
+      operator value_type() const noexcept{
+          return owner->get(lane);
+      }
+
+      reference& operator=(value_type value) noexcept{
+          owner->set(lane, value);
+          return *this;
+      }
+
+      reference& operator=(const reference& other) noexcept{
+          return *this = static_cast<value_type>(other);
+      }
+
+   private:
+      friend class PackedDeque;
+      reference(PackedDeque* owner, size_type lane) noexcept : owner(owner), lane(lane) {}
+
+      PackedDeque* owner;
+      size_type lane;
+  };
+
+  /// @brief Constructs an empty deque.
+  PackedDeque() : words(1) {}
+
+  /// @brief Constructs the container with count copies of value.
+  PackedDeque(size_type count, value_type value) : words(1){
+      reserve(count);
+      _size = count;
+      fill(value);
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Number of elements the buffer holds before it grows.
+  size_type capacity() const noexcept{
+      return words.size() * lanes_per_word;
+  }
+
+  /// @brief Bytes used by the packed words.
+  size_type memory_usage() const noexcept{
+      return words.capacity() * sizeof(std::uint64_t);
+  }
+
+  /// @brief Grows the buffer to hold at least count elements.
+  void reserve(size_type count){
+      size_type lanes = capacity();
+      while(lanes < count) lanes *= 2;
+      if(lanes != capacity()) regrow(lanes / lanes_per_word);
+  }
+
+  /// @brief Returns a proxy reference to the element at pos. No bounds
+  /// checking is performed.
+  reference operator[](size_type pos) noexcept{
+      return reference(this, slot(pos));
+  }
+
+  value_type operator[](size_type pos) const noexcept{
+      return get(slot(pos));
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  reference at(size_type pos){
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  value_type at(size_type pos) const{
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  reference front() noexcept{
+      return operator[](0);
+  }
+
+  value_type front() const noexcept{
+      return operator[](0);
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  reference back() noexcept{
+      return operator[](_size - 1);
+  }
+
+  value_type back() const noexcept{
+      return operator[](_size - 1);
+  }
+
+  /// @brief Appends value to the end.
+  void push_back(value_type value){
+      if(_size == capacity()) regrow(words.size() * 2);
+      set(slot(_size), value);
+      _size++;
+  }
+
+  /// @brief Prepends value to the beginning.
+  void push_front(value_type value){
+      if(_size == capacity()) regrow(words.size() * 2);
+      head = (head + capacity() - 1) & (capacity() - 1);
+      set(head, value);
+      _size++;
+  }
+
+  /// @brief Removes the last element. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back() noexcept{
+      _size--;
+  }
+
+  /// @brief Removes the first element. Calling pop_front on an empty
+  /// container is undefined.
+  void pop_front() noexcept{
+      head = (head + 1) & (capacity() - 1);
+      _size--;
+  }
+
+  /// @brief Erases all elements. The buffer keeps its capacity.
+  void clear() noexcept{
+      head = 0;
+      _size = 0;
+  }
+
+  /// @brief Counts elements equal to value, one word at a time.
+  size_type count(value_type value) const noexcept{
+      std::uint64_t pattern = broadcast(value);
+      size_type equal = 0;
+      for_each_word([&](std::uint64_t word, std::uint64_t mask){
+          //Дорожки, равные value, после xor нулевые; сворачиваем каждую дорожку в ее младший бит.
+          std::uint64_t x = word ^ pattern;
+          for(unsigned shift = 1; shift < Bits; shift <<= 1) x |= x >> shift;
+          std::uint64_t lows = mask & low_bits();
+          equal += popcount(lows) - popcount(x & lows);
+      });
+      return equal;
+  }
+
+  /// @brief Counts non-zero elements; for PackedDeque<1> the number of set
+  /// bits.
+  size_type count() const noexcept{
+      return _size - count(value_type(0));
+  }
+
+  /// @brief Checks if any element is non-zero.
+  bool any() const noexcept{
+      bool found = false;
+      for_each_word([&](std::uint64_t word, std::uint64_t mask){
+          found = found || (word & mask) != 0;
+      });
+      return found;
+  }
+
+  /// @brief Sets every element to value, one word at a time.
+  void fill(value_type value) noexcept{
+      std::uint64_t pattern = broadcast(value);
+      for_each_range([&](size_type index, std::uint64_t mask){
+          words[index] = (words[index] & ~mask) | (pattern & mask);
+      });
+  }
+
+  /// @brief Calls f(value) for every element from front to back.
+  template <class F>
+  void for_each(F f) const{
+      for(size_type i = 0; i < _size; i++) f(operator[](i));
+  }
+
+ private:
+  static constexpr size_type lanes_per_word = 64 / Bits;
+  static constexpr std::uint64_t lane_mask = (std::uint64_t(1) << Bits) - 1;
+
+  static size_type popcount(std::uint64_t word) noexcept{
+      return static_cast<size_type>(__builtin_popcountll(word));
+  }
+
+  //Единица в младшем бите каждой дорожки.
+  static std::uint64_t low_bits() noexcept{
+      return ~std::uint64_t(0) / lane_mask;
+  }
+
+  static std::uint64_t broadcast(value_type value) noexcept{
+      return low_bits() * (static_cast<std::uint64_t>(value) & lane_mask);
+  }
+
+  size_type slot(size_type pos) const noexcept{
+      return (head + pos) & (capacity() - 1);
+  }
+
+  value_type get(size_type lane) const noexcept{
+      std::uint64_t word = words[lane / lanes_per_word] >> (lane % lanes_per_word * Bits);
+      return static_cast<value_type>(word & lane_mask);
+  }
+
+  void set(size_type lane, value_type value) noexcept{
+      unsigned shift = static_cast<unsigned>(lane % lanes_per_word * Bits);
+      std::uint64_t& word = words[lane / lanes_per_word];
+      word = (word & ~(lane_mask << shift)) | ((static_cast<std::uint64_t>(value) & lane_mask) << shift);
+  }
+
+  //Занятые дорожки кольца - не больше двух непрерывных отрезков. f(index, mask) вызывается для каждого
+  //слова, которого они касаются; mask - биты занятых дорожек в этом слове.
+  template <class F>
+  void for_each_range(F f) const{
+      if(_size == 0) return;
+      size_type end = head + _size;
+      if(end <= capacity()){
+          linear_range(head, end, f);
+      }
+      else{
+          linear_range(head, capacity(), f);
+          linear_range(0, end - capacity(), f);
+      }
+  }
+
+  template <class F>
+  static void linear_range(size_type from, size_type to, F& f){
+      size_type first = from / lanes_per_word;
+      size_type last = (to - 1) / lanes_per_word;
+      for(size_type index = first; index <= last; index++){
+          std::uint64_t mask = ~std::uint64_t(0);
+          if(index == first) mask &= ~std::uint64_t(0) << (from % lanes_per_word * Bits);
+          if(index == last && to % lanes_per_word != 0) mask &= ~(~std::uint64_t(0) << (to % lanes_per_word * Bits));
+          f(index, mask);
+      }
+  }
+
+  template <class F>
+  void for_each_word(F f) const{
+      for_each_range([&](size_type index, std::uint64_t mask){ f(words[index], mask); });
+  }
+
+  //Переносит элементы в новый буфер из count слов, начиная с дорожки 0.
+  void regrow(size_type count){
+      PackedDeque grown;
+      grown.words.assign(count, 0);
+      for(size_type i = 0; i < _size; i++) grown.set(i, get(slot(i)));
+      words.swap(grown.words);
+      head = 0;
+  }
+
+  std::vector<std::uint64_t> words;
+  size_type head = 0; //Дорожка первого элемента.
+  size_type _size = 0;
+};
+
+/// @brief Deque of bools stored one bit per element.
+using BitDeque = PackedDeque<1>;
+
+}  // namespace fefu_laboratory_two
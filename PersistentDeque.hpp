@@ -0,0 +1,378 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace fefu_laboratory_two {
+
+// Неизменяемый (persistent) дек на 2-3 finger tree (Hinze, Paterson). Каждая операция возвращает новую версию,
+// старая остается доступной, а общие поддеревья разделяются между версиями через shared_ptr.
+// push/pop с обоих концов амортизированно O(1), доступ по индексу и set - O(log n).
+// Узлы на всех уровнях дерева имеют общую часть Node (размер и арность): лист Leaf хранит значение, внутренний
+// узел Branch - 2 или 3 поддерева. Внутренние узлы не хранят T, поэтому T не обязан иметь конструктор по умолчанию.
+template <typename T>
+class PersistentDeque {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using const_reference = const value_type&;
+
+ private:
+  struct Node;
+  struct Leaf;
+  struct Branch;
+  struct Tree;
+  using node_ptr = std::shared_ptr<const Node>;
+  using tree_ptr = std::shared_ptr<const Tree>;
+
+  //Узел хранится в shared_ptr<const Node>, созданном make_shared от Leaf или Branch, так что удаляется
+  //настоящий тип и виртуальный деструктор не нужен.
+  struct Node {
+      size_type size;
+      unsigned char arity; //0 - Leaf, 2 или 3 - Branch
+
+      Node(size_type size, unsigned char arity) : size(size), arity(arity) {}
+  };
+
+  struct Leaf : Node {
+      T value;
+
+      explicit Leaf(const T& value) : Node(1, 0), value(value) {}
+  };
+
+  struct Branch : Node {
+      node_ptr child[3];
+
+      Branch(node_ptr a, node_ptr b) : Node(a->size + b->size, 2), child{std::move(a), std::move(b), nullptr} {}
+      Branch(node_ptr a, node_ptr b, node_ptr c)
+          : Node(a->size + b->size + c->size, 3), child{std::move(a), std::move(b), std::move(c)} {}
+  };
+
+  //Цифра (digit) - от 1 до 4 узлов на конце дерева.
+  struct Digit {
+      node_ptr items[4];
+      unsigned char count = 0;
+
+      size_type size() const{
+          size_type total = 0;
+          for(unsigned char i = 0; i < count; i++) total += items[i]->size;
+          return total;
+      }
+  };
+
+  //Пустое дерево - nullptr. Single - одно поддерево, Deep - префикс, дерево узлов следующего уровня и суффикс.
+  struct Tree {
+      size_type size;
+      node_ptr single;
+      Digit prefix;
+      tree_ptr middle;
+      Digit suffix;
+
+      explicit Tree(node_ptr node) : size(node->size), single(std::move(node)) {}
+      Tree(const Digit& prefix, tree_ptr middle, const Digit& suffix)
+          : size(prefix.size() + (middle ? middle->size : 0) + suffix.size()),
+            prefix(prefix), middle(std::move(middle)), suffix(suffix) {}
+  };
+
+ public:
+  /// @brief Constructs an empty deque.
+  PersistentDeque() = default;
+
+  /// @brief Returns the number of elements in this version
+  size_type size() const noexcept{
+      return root ? root->size : 0;
+  }
+
+  /// @brief Checks if this version has no elements
+  bool empty() const noexcept{
+      return root == nullptr;
+  }
+
+  /// @brief Returns a new version with value appended to the end. *this is
+  /// not changed. Complexity: amortized constant.
+  PersistentDeque push_back(const T& value) const{
+      return PersistentDeque(push_back(root, std::make_shared<const Leaf>(value)));
+  }
+
+  /// @brief Returns a new version with value prepended to the beginning.
+  /// *this is not changed. Complexity: amortized constant.
+  PersistentDeque push_front(const T& value) const{
+      return PersistentDeque(push_front(root, std::make_shared<const Leaf>(value)));
+  }
+
+  /// @brief Returns a new version without the last element. Calling pop_back
+  /// on an empty deque is undefined. Complexity: amortized constant.
+  PersistentDeque pop_back() const{
+      node_ptr node;
+      return PersistentDeque(pop_back(root, node));
+  }
+
+  /// @brief Returns a new version without the first element. Calling
+  /// pop_front on an empty deque is undefined. Complexity: amortized constant.
+  PersistentDeque pop_front() const{
+      node_ptr node;
+      return PersistentDeque(pop_front(root, node));
+  }
+
+  /// @brief Returns a new version where the element at pos is replaced by
+  /// value. Only the path to the element is copied. No bounds checking is
+  /// performed. Complexity: O(log n).
+  PersistentDeque set(size_type pos, const T& value) const{
+      return PersistentDeque(set(root, pos, value));
+  }
+
+  /// @brief Returns a const reference to the first element. Calling front on
+  /// an empty deque is undefined.
+  const_reference front() const{
+      const Tree& tree = *root;
+      return value_of(leftmost(tree.single ? tree.single : tree.prefix.items[0]));
+  }
+
+  /// @brief Returns a const reference to the last element. Calling back on an
+  /// empty deque is undefined.
+  const_reference back() const{
+      const Tree& tree = *root;
+      return value_of(rightmost(tree.single ? tree.single : tree.suffix.items[tree.suffix.count - 1]));
+  }
+
+  /// @brief Returns a const reference to the element at pos. No bounds
+  /// checking is performed. Complexity: O(log n).
+  const_reference operator[](size_type pos) const{
+      return value_of(find(root.get(), pos));
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  const_reference at(size_type pos) const{
+      if(pos >= size()) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Calls f for every element, front to back. Complexity: linear.
+  template <class F>
+  void for_each(F f) const{
+      for_each(root.get(), f);
+  }
+
+ private:
+  explicit PersistentDeque(tree_ptr root) : root(std::move(root)) {}
+
+  static const T& value_of(const Node* leaf){
+      return static_cast<const Leaf*>(leaf)->value;
+  }
+
+  static const node_ptr* children(const Node* branch){
+      return static_cast<const Branch*>(branch)->child;
+  }
+
+  static Digit digit(node_ptr a){
+      Digit d;
+      d.items[0] = std::move(a);
+      d.count = 1;
+      return d;
+  }
+
+  static Digit digit(const Node& node){
+      Digit d;
+      for(unsigned char i = 0; i < node.arity; i++) d.items[i] = children(&node)[i];
+      d.count = node.arity;
+      return d;
+  }
+
+  static tree_ptr deep(const Digit& prefix, tree_ptr middle, const Digit& suffix){
+      return std::make_shared<const Tree>(prefix, std::move(middle), suffix);
+  }
+
+  static tree_ptr push_front(const tree_ptr& tree, node_ptr a){
+      if(!tree) return std::make_shared<const Tree>(std::move(a));
+      if(tree->single) return deep(digit(std::move(a)), nullptr, digit(tree->single));
+      const Digit& pr = tree->prefix;
+      Digit prefix;
+      if(pr.count < 4){
+          prefix.items[0] = std::move(a);
+          for(unsigned char i = 0; i < pr.count; i++) prefix.items[i + 1] = pr.items[i];
+          prefix.count = pr.count + 1;
+          return deep(prefix, tree->middle, tree->suffix);
+      }
+      //Префикс полон: оставляем два узла, три уходят одним узлом на следующий уровень.
+      prefix.items[0] = std::move(a);
+      prefix.items[1] = pr.items[0];
+      prefix.count = 2;
+      node_ptr node = std::make_shared<const Branch>(pr.items[1], pr.items[2], pr.items[3]);
+      return deep(prefix, push_front(tree->middle, std::move(node)), tree->suffix);
+  }
+
+  static tree_ptr push_back(const tree_ptr& tree, node_ptr a){
+      if(!tree) return std::make_shared<const Tree>(std::move(a));
+      if(tree->single) return deep(digit(tree->single), nullptr, digit(std::move(a)));
+      const Digit& sf = tree->suffix;
+      Digit suffix;
+      if(sf.count < 4){
+          suffix = sf;
+          suffix.items[suffix.count++] = std::move(a);
+          return deep(tree->prefix, tree->middle, suffix);
+      }
+      suffix.items[0] = sf.items[3];
+      suffix.items[1] = std::move(a);
+      suffix.count = 2;
+      node_ptr node = std::make_shared<const Branch>(sf.items[0], sf.items[1], sf.items[2]);
+      return deep(tree->prefix, push_back(tree->middle, std::move(node)), suffix);
+  }
+
+  static tree_ptr digit_to_tree(const Digit& d){
+      tree_ptr tree;
+      for(unsigned char i = 0; i < d.count; i++) tree = push_back(tree, d.items[i]);
+      return tree;
+  }
+
+  //Снимает первый узел дерева в node и возвращает остаток.
+  static tree_ptr pop_front(const tree_ptr& tree, node_ptr& node){
+      if(tree->single){
+          node = tree->single;
+          return nullptr;
+      }
+      const Digit& pr = tree->prefix;
+      node = pr.items[0];
+      if(pr.count > 1){
+          Digit prefix;
+          for(unsigned char i = 1; i < pr.count; i++) prefix.items[i - 1] = pr.items[i];
+          prefix.count = pr.count - 1;
+          return deep(prefix, tree->middle, tree->suffix);
+      }
+      if(!tree->middle) return digit_to_tree(tree->suffix);
+      //Префикс опустел: берем узел со следующего уровня и раскрываем его в новый префикс.
+      node_ptr inner;
+      tree_ptr middle = pop_front(tree->middle, inner);
+      return deep(digit(*inner), std::move(middle), tree->suffix);
+  }
+
+  static tree_ptr pop_back(const tree_ptr& tree, node_ptr& node){
+      if(tree->single){
+          node = tree->single;
+          return nullptr;
+      }
+      const Digit& sf = tree->suffix;
+      node = sf.items[sf.count - 1];
+      if(sf.count > 1){
+          Digit suffix = sf;
+          suffix.items[--suffix.count] = nullptr;
+          return deep(tree->prefix, tree->middle, suffix);
+      }
+      if(!tree->middle) return digit_to_tree(tree->prefix);
+      node_ptr inner;
+      tree_ptr middle = pop_back(tree->middle, inner);
+      return deep(tree->prefix, std::move(middle), digit(*inner));
+  }
+
+  static const Node* leftmost(const node_ptr& node){
+      const Node* cur = node.get();
+      while(cur->arity != 0) cur = children(cur)[0].get();
+      return cur;
+  }
+
+  static const Node* rightmost(const node_ptr& node){
+      const Node* cur = node.get();
+      while(cur->arity != 0) cur = children(cur)[cur->arity - 1].get();
+      return cur;
+  }
+
+  //Спуск от узла к листу с номером pos внутри него.
+  static const Node* descend(const Node* cur, size_type pos){
+      while(cur->arity != 0){
+          const node_ptr* child = children(cur);
+          unsigned char i = 0;
+          while(pos >= child[i]->size){
+              pos -= child[i]->size;
+              i++;
+          }
+          cur = child[i].get();
+      }
+      return cur;
+  }
+
+  static const Node* find(const Digit& d, size_type pos){
+      unsigned char i = 0;
+      while(pos >= d.items[i]->size){
+          pos -= d.items[i]->size;
+          i++;
+      }
+      return descend(d.items[i].get(), pos);
+  }
+
+  static const Node* find(const Tree* tree, size_type pos){
+      if(tree->single) return descend(tree->single.get(), pos);
+      size_type prefix_size = tree->prefix.size();
+      if(pos < prefix_size) return find(tree->prefix, pos);
+      pos -= prefix_size;
+      size_type middle_size = tree->middle ? tree->middle->size : 0;
+      if(pos < middle_size) return find(tree->middle.get(), pos);
+      return find(tree->suffix, pos - middle_size);
+  }
+
+  //Копия узла, в которой заменен лист pos; остальные поддеревья общие со старой версией.
+  static node_ptr set(const node_ptr& node, size_type pos, const T& value){
+      if(node->arity == 0) return std::make_shared<const Leaf>(value);
+      const node_ptr* old = children(node.get());
+      node_ptr child[3] = {old[0], old[1], old[2]};
+      unsigned char i = 0;
+      while(pos >= child[i]->size){
+          pos -= child[i]->size;
+          i++;
+      }
+      child[i] = set(child[i], pos, value);
+      if(node->arity == 2) return std::make_shared<const Branch>(child[0], child[1]);
+      return std::make_shared<const Branch>(child[0], child[1], child[2]);
+  }
+
+  static Digit set(const Digit& d, size_type pos, const T& value){
+      Digit copy = d;
+      unsigned char i = 0;
+      while(pos >= copy.items[i]->size){
+          pos -= copy.items[i]->size;
+          i++;
+      }
+      copy.items[i] = set(copy.items[i], pos, value);
+      return copy;
+  }
+
+  static tree_ptr set(const tree_ptr& tree, size_type pos, const T& value){
+      if(tree->single) return std::make_shared<const Tree>(set(tree->single, pos, value));
+      size_type prefix_size = tree->prefix.size();
+      if(pos < prefix_size) return deep(set(tree->prefix, pos, value), tree->middle, tree->suffix);
+      pos -= prefix_size;
+      size_type middle_size = tree->middle ? tree->middle->size : 0;
+      if(pos < middle_size) return deep(tree->prefix, set(tree->middle, pos, value), tree->suffix);
+      return deep(tree->prefix, tree->middle, set(tree->suffix, pos - middle_size, value));
+  }
+
+  template <class F>
+  static void for_each(const Node* node, F& f){
+      if(node->arity == 0){
+          f(value_of(node));
+          return;
+      }
+      for(unsigned char i = 0; i < node->arity; i++) for_each(children(node)[i].get(), f);
+  }
+
+  template <class F>
+  static void for_each(const Digit& d, F& f){
+      for(unsigned char i = 0; i < d.count; i++) for_each(d.items[i].get(), f);
+  }
+
+  template <class F>
+  static void for_each(const Tree* tree, F& f){
+      if(tree == nullptr) return;
+      if(tree->single){
+          for_each(tree->single.get(), f);
+          return;
+      }
+      for_each(tree->prefix, f);
+      for_each(tree->middle.get(), f);
+      for_each(tree->suffix, f);
+  }
+
+  tree_ptr root;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,240 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Дек байтовых записей переменной длины. Записи лежат вплотную друг к другу в блоках-аренах по chunk_bytes
+// байт, у каждого блока свой компактный индекс - границы записей в виде 32-битных смещений. Блоки,
+// заведенные push_back, заполняются вперед, заведенные push_front - назад от конца. Блок освобождается
+// целиком, когда из него забрана последняя запись, а один свободный блок остается про запас,
+// так что в установившемся режиме push и pop не выделяют память.
+class RecordDeque {
+ public:
+  using value_type = std::string_view;
+  using size_type = std::size_t;
+
+  /// @brief Constructs an empty deque.
+  /// @param chunk_bytes size of one arena chunk; longer records get a chunk
+  /// of their own
+  explicit RecordDeque(size_type chunk_bytes = 65536) : chunk_bytes(chunk_bytes ? chunk_bytes : 1) {}
+
+  RecordDeque(const RecordDeque&) = delete;
+  RecordDeque& operator=(const RecordDeque&) = delete;
+
+  /// @brief Returns the number of records in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no records
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Returns the number of arena chunks in use.
+  size_type chunk_count() const noexcept{
+      return chunks.size() - head;
+  }
+
+  /// @brief Returns the number of slots in the chunk directory, including
+  /// the free ones before the first chunk.
+  size_type directory_slots() const noexcept{
+      return chunks.size();
+  }
+
+  /// @brief Returns a view of the record at pos, valid until the record is
+  /// popped. The chunk is found by binary search over the chunk directory.
+  /// No bounds checking is performed.
+  value_type operator[](size_type pos) const{
+      std::uint64_t seq = chunks[head]->first_seq + pos;
+      auto it = std::upper_bound(chunks.begin() + head, chunks.end(), seq,
+                                 [](std::uint64_t s, const std::unique_ptr<Chunk>& c){ return s < c->first_seq; });
+      const Chunk& chunk = **(it - 1);
+      return record(chunk, static_cast<size_type>(seq - chunk.first_seq));
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  value_type at(size_type pos) const{
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return operator[](pos);
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  value_type front() const{
+      return record(*chunks[head], 0);
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  value_type back() const{
+      const Chunk& chunk = *chunks.back();
+      return record(chunk, chunk.live() - 1);
+  }
+
+  /// @brief Copies record to the end.
+  /// @throw std::length_error if the record is longer than 4 GiB
+  void push_back(value_type record){
+      check_length(record);
+      if(head == chunks.size() || chunks.back()->reversed ||
+         chunks.back()->capacity - chunks.back()->bounds.back() < record.size()){
+          std::uint64_t seq = head == chunks.size() ? initial_seq : chunks.back()->first_seq + chunks.back()->live();
+          chunks.push_back(new_chunk(record.size(), false));
+          chunks.back()->first_seq = seq;
+      }
+      Chunk& chunk = *chunks.back();
+      std::uint32_t at = chunk.bounds.back();
+      std::memcpy(chunk.data.get() + at, record.data(), record.size());
+      chunk.bounds.push_back(at + static_cast<std::uint32_t>(record.size()));
+      _size++;
+  }
+
+  /// @brief Copies record to the beginning.
+  /// @throw std::length_error if the record is longer than 4 GiB
+  void push_front(value_type record){
+      check_length(record);
+      if(head == chunks.size() || !chunks[head]->reversed || chunks[head]->bounds.back() < record.size()){
+          std::uint64_t seq = head == chunks.size() ? initial_seq : chunks[head]->first_seq;
+          if(head == 0) make_room_in_front();
+          chunks[--head] = new_chunk(record.size(), true);
+          chunks[head]->first_seq = seq;
+      }
+      Chunk& chunk = *chunks[head];
+      std::uint32_t at = chunk.bounds.back() - static_cast<std::uint32_t>(record.size());
+      std::memcpy(chunk.data.get() + at, record.data(), record.size());
+      chunk.bounds.push_back(at);
+      chunk.first_seq--;
+      _size++;
+  }
+
+  /// @brief Removes the first record, releasing its chunk if it was the last
+  /// one there. Calling pop_front on an empty container is undefined.
+  void pop_front(){
+      Chunk& chunk = *chunks[head];
+      if(chunk.reversed) chunk.bounds.pop_back();
+      else chunk.skip++;
+      chunk.first_seq++;
+      _size--;
+      if(chunk.live() == 0){
+          recycle(std::move(chunks[head]));
+          head++;
+          //Освободившиеся места каталога перед head забираем, когда их больше половины.
+          if(head == chunks.size()) reset();
+          else if(head > chunks.size() / 2){
+              chunks.erase(chunks.begin(), chunks.begin() + head);
+              head = 0;
+          }
+      }
+  }
+
+  /// @brief Removes the last record, releasing its chunk if it was the last
+  /// one there. Calling pop_back on an empty container is undefined.
+  void pop_back(){
+      Chunk& chunk = *chunks.back();
+      if(chunk.reversed) chunk.skip++;
+      else chunk.bounds.pop_back();
+      _size--;
+      if(chunk.live() == 0){
+          recycle(std::move(chunks.back()));
+          chunks.pop_back();
+          if(head == chunks.size()) reset();
+      }
+  }
+
+  /// @brief Erases all records.
+  void clear() noexcept{
+      reset();
+      _size = 0;
+  }
+
+  /// @brief Calls f(record) for every record from front to back.
+  template <class F>
+  void for_each(F f) const{
+      for(size_type i = head; i < chunks.size(); i++){
+          const Chunk& chunk = *chunks[i];
+          for(size_type j = 0; j < chunk.live(); j++) f(record(chunk, j));
+      }
+  }
+
+ private:
+  //Записи блока в порядке добавления: k-я занимает байты между bounds[k] и bounds[k + 1]. Блок растет
+  //только с одного конца (вперед или назад, reversed), а skip записей забрано с противоположного.
+  struct Chunk {
+      std::unique_ptr<char[]> data;
+      size_type capacity = 0;
+      std::vector<std::uint32_t> bounds;
+      size_type skip = 0;
+      bool reversed = false;
+      std::uint64_t first_seq = 0; //Сквозной номер первой живой записи, у соседних блоков номера идут подряд.
+
+      size_type live() const noexcept{
+          return bounds.size() - 1 - skip;
+      }
+  };
+
+  //Номера записей начинаются с середины диапазона, чтобы push_front мог их уменьшать.
+  static constexpr std::uint64_t initial_seq = std::uint64_t(1) << 63;
+
+  static void check_length(value_type record){
+      if(record.size() > UINT32_MAX) throw std::length_error("RecordDeque: record is too long");
+  }
+
+  //Запись номер j от начала блока.
+  static value_type record(const Chunk& chunk, size_type j) noexcept{
+      size_type k = chunk.reversed ? chunk.bounds.size() - 2 - j : chunk.skip + j;
+      std::uint32_t from = chunk.bounds[k];
+      std::uint32_t to = chunk.bounds[k + 1];
+      if(chunk.reversed) std::swap(from, to);
+      return value_type(chunk.data.get() + from, to - from);
+  }
+
+  std::unique_ptr<Chunk> new_chunk(size_type record_bytes, bool reversed){
+      std::unique_ptr<Chunk> chunk;
+      if(spare && record_bytes <= spare->capacity){
+          chunk = std::move(spare);
+      }
+      else{
+          chunk.reset(new Chunk);
+          chunk->capacity = std::max(chunk_bytes, record_bytes);
+          chunk->data.reset(new char[chunk->capacity]);
+      }
+      chunk->bounds.clear();
+      chunk->bounds.push_back(reversed ? static_cast<std::uint32_t>(chunk->capacity) : 0);
+      chunk->skip = 0;
+      chunk->reversed = reversed;
+      return chunk;
+  }
+
+  //Освободившийся блок обычного размера остается про запас; блоки под длинные записи отдаются сразу.
+  void recycle(std::unique_ptr<Chunk> chunk){
+      if(chunk->capacity == chunk_bytes) spare = std::move(chunk);
+  }
+
+  //Сдвигаем занятые блоки вправо, чтобы перед head появилось место. Амортизированно O(1) на push_front.
+  void make_room_in_front(){
+      size_type used = chunks.size() - head;
+      size_type room = used > 4 ? used : 4;
+      std::vector<std::unique_ptr<Chunk>> moved(room + used);
+      std::move(chunks.begin() + head, chunks.end(), moved.begin() + room);
+      chunks.swap(moved);
+      head = room;
+  }
+
+  void reset() noexcept{
+      chunks.clear();
+      head = 0;
+  }
+
+  std::vector<std::unique_ptr<Chunk>> chunks; //Занята часть [head, chunks.size()).
+  std::unique_ptr<Chunk> spare;
+  size_type head = 0;
+  size_type _size = 0;
+  size_type chunk_bytes;
+};
+
+}  // namespace fefu_laboratory_two
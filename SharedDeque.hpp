@@ -0,0 +1,237 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fefu_laboratory_two {
+
+// Очередь между процессами в разделяемой памяти POSIX (shm_open + mmap): один процесс пишет в конец,
+// другой забирает с начала. В сегменте нет указателей, только индексы head/tail в кольцевом буфере,
+// поэтому процессы могут отобразить его по разным адресам. head и tail - атомарные счетчики на отдельных
+// кэш-линиях; блокирующие push_back/pop_front засыпают на futex и будятся только если кто-то ждет.
+// Только для тривиально копируемых T, один производитель и один потребитель.
+template <typename T>
+class SharedDeque {
+  static_assert(std::is_trivially_copyable<T>::value, "SharedDeque needs a trivially copyable T");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SharedDeque needs lock-free 64-bit atomics");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  /// @brief Creates the shared-memory segment name with room for capacity
+  /// elements, rounded up to a power of two. An existing segment is never
+  /// re-initialized under a process that may still be using it: remove a
+  /// stale one with unlink() first.
+  /// @param name shared-memory object name, e.g. "/events"
+  /// @param capacity number of elements the ring can hold
+  /// @throw std::system_error if the segment cannot be created or mapped,
+  /// with EEXIST if a segment with this name already exists
+  SharedDeque(const std::string& name, size_type capacity){
+      size_type rounded = 1;
+      while(rounded < capacity) rounded <<= 1;
+      fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      if(fd < 0) throw std::system_error(errno, std::generic_category(), "SharedDeque: shm_open " + name);
+      try{
+          if(::ftruncate(fd, static_cast<off_t>(segment_size(rounded))) != 0) fail("SharedDeque: ftruncate");
+          map(segment_size(rounded));
+      }
+      catch(...){
+          ::shm_unlink(name.c_str());
+          throw;
+      }
+      header->capacity = rounded;
+      header->element_size = sizeof(value_type);
+      header->head.store(0, std::memory_order_relaxed);
+      header->tail.store(0, std::memory_order_relaxed);
+      header->pushed.store(0, std::memory_order_relaxed);
+      header->popped.store(0, std::memory_order_relaxed);
+      header->consumer_waiting.store(0, std::memory_order_relaxed);
+      header->producer_waiting.store(0, std::memory_order_relaxed);
+      header->version = segment_version;
+      std::atomic_thread_fence(std::memory_order_release);
+      std::memcpy(header->magic, segment_magic(), sizeof(header->magic));
+  }
+
+  /// @brief Opens an existing segment created by another process.
+  /// @param name shared-memory object name
+  /// @throw std::system_error if the segment cannot be opened or mapped
+  /// @throw std::runtime_error if it is not a SharedDeque of T
+  explicit SharedDeque(const std::string& name){
+      fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+      if(fd < 0) throw std::system_error(errno, std::generic_category(), "SharedDeque: shm_open " + name);
+      struct stat st;
+      if(::fstat(fd, &st) != 0) fail("SharedDeque: fstat");
+      if(static_cast<size_type>(st.st_size) < sizeof(Header)) close_and_throw("SharedDeque: segment is too short");
+      map(static_cast<size_type>(st.st_size));
+      if(std::memcmp(header->magic, segment_magic(), sizeof(header->magic)) != 0) close_and_throw("SharedDeque: not a deque segment");
+      if(header->version != segment_version) close_and_throw("SharedDeque: unsupported segment version");
+      if(header->element_size != sizeof(value_type)) close_and_throw("SharedDeque: element size mismatch");
+      if(segment_size(header->capacity) > mapped_bytes) close_and_throw("SharedDeque: segment is truncated");
+  }
+
+  SharedDeque(const SharedDeque&) = delete;
+  SharedDeque& operator=(const SharedDeque&) = delete;
+
+  /// @brief Unmaps the segment. The segment itself stays until unlink().
+  ~SharedDeque(){
+      if(base != nullptr) ::munmap(base, mapped_bytes);
+      if(fd >= 0) ::close(fd);
+  }
+
+  /// @brief Removes the shared-memory object name.
+  static void unlink(const std::string& name){
+      ::shm_unlink(name.c_str());
+  }
+
+  /// @brief Number of elements the ring can hold.
+  size_type capacity() const noexcept{
+      return static_cast<size_type>(header->capacity);
+  }
+
+  /// @brief Number of elements at the moment of the call.
+  size_type size() const noexcept{
+      return static_cast<size_type>(header->tail.load(std::memory_order_acquire) - header->head.load(std::memory_order_acquire));
+  }
+
+  /// @brief Checks if the queue was empty at the moment of the call.
+  bool empty() const noexcept{
+      return size() == 0;
+  }
+
+  /// @brief Producer side. Appends value if there is room; never blocks and
+  /// never makes a system call unless the consumer is asleep.
+  /// @return false if the ring is full.
+  bool try_push_back(const T& value) noexcept{
+      std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+      if(tail - header->head.load(std::memory_order_acquire) == header->capacity) return false;
+      data[tail & (header->capacity - 1)] = value;
+      header->tail.store(tail + 1, std::memory_order_release);
+      wake(header->pushed, header->consumer_waiting);
+      return true;
+  }
+
+  /// @brief Producer side. Appends value, sleeping on a futex while the ring
+  /// is full.
+  void push_back(const T& value){
+      while(!try_push_back(value)){
+          wait(header->popped, header->producer_waiting, [&]{
+              return header->tail.load(std::memory_order_relaxed) - header->head.load(std::memory_order_acquire) < header->capacity;
+          });
+      }
+  }
+
+  /// @brief Consumer side. Removes the first element into value if there is
+  /// one; never blocks.
+  /// @return false if the ring is empty.
+  bool try_pop_front(T& value) noexcept{
+      std::uint64_t head = header->head.load(std::memory_order_relaxed);
+      if(head == header->tail.load(std::memory_order_acquire)) return false;
+      value = data[head & (header->capacity - 1)];
+      header->head.store(head + 1, std::memory_order_release);
+      wake(header->popped, header->producer_waiting);
+      return true;
+  }
+
+  /// @brief Consumer side. Removes and returns the first element, sleeping on
+  /// a futex while the ring is empty.
+  T pop_front(){
+      T value;
+      while(!try_pop_front(value)){
+          wait(header->pushed, header->consumer_waiting, [&]{
+              return header->head.load(std::memory_order_relaxed) != header->tail.load(std::memory_order_acquire);
+          });
+      }
+      return value;
+  }
+
+ private:
+  //head и tail на разных кэш-линиях, чтобы производитель и потребитель не мешали друг другу.
+  struct Header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t element_size;
+      std::uint64_t capacity;
+      alignas(64) std::atomic<std::uint64_t> head;
+      alignas(64) std::atomic<std::uint64_t> tail;
+      alignas(64) std::atomic<std::uint32_t> pushed; //futex-слова: счетчики, на которых спят стороны
+      std::atomic<std::uint32_t> popped;
+      std::atomic<std::uint32_t> consumer_waiting;
+      std::atomic<std::uint32_t> producer_waiting;
+  };
+
+  static const char* segment_magic() noexcept{
+      return "FDQSHM1";
+  }
+
+  static constexpr std::uint32_t segment_version = 1;
+  static constexpr size_type data_offset = (sizeof(Header) + 63) / 64 * 64;
+
+  static size_type segment_size(size_type capacity){
+      return data_offset + capacity * sizeof(value_type);
+  }
+
+  static long futex(std::atomic<std::uint32_t>& word, int op, std::uint32_t value){
+      return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), op, value, nullptr, nullptr, 0);
+  }
+
+  //Другая сторона спит только если выставила флаг waiting, иначе системный вызов не нужен.
+  static void wake(std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& waiting) noexcept{
+      word.fetch_add(1, std::memory_order_seq_cst);
+      if(waiting.load(std::memory_order_seq_cst) != 0) futex(word, FUTEX_WAKE, INT_MAX);
+  }
+
+  //Выставляем флаг, перепроверяем условие и засыпаем, пока счетчик word не изменится.
+  template <class Ready>
+  static void wait(std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& waiting, Ready ready){
+      std::uint32_t seen = word.load(std::memory_order_seq_cst);
+      waiting.store(1, std::memory_order_seq_cst);
+      if(!ready()) futex(word, FUTEX_WAIT, seen);
+      waiting.store(0, std::memory_order_seq_cst);
+  }
+
+  void map(size_type bytes){
+      void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED) fail("SharedDeque: mmap");
+      base = p;
+      mapped_bytes = bytes;
+      header = static_cast<Header*>(base);
+      data = reinterpret_cast<value_type*>(static_cast<char*>(base) + data_offset);
+  }
+
+  [[noreturn]] void fail(const char* what){
+      int error = errno;
+      ::close(fd);
+      fd = -1;
+      throw std::system_error(error, std::generic_category(), what);
+  }
+
+  [[noreturn]] void close_and_throw(const char* what){
+      ::munmap(base, mapped_bytes);
+      ::close(fd);
+      base = nullptr;
+      fd = -1;
+      throw std::runtime_error(what);
+  }
+
+  int fd = -1;
+  void* base = nullptr;
+  size_type mapped_bytes = 0;
+  Header* header = nullptr;
+  value_type* data = nullptr;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,240 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Дек записей из нескольких полей, разложенных по столбцам (struct of arrays). Записи лежат в блоках по
+// block_records штук, в каждом блоке у каждого поля свой массив. Проход по одному полю читает только
+// его массивы: for_each_span отдает их непрерывными кусками, удобными для векторизованных циклов.
+// Все блоки, кроме первого и последнего, полные, поэтому запись по индексу находится за O(1).
+template <typename... Fields>
+class SoaDeque {
+  static_assert(sizeof...(Fields) > 0, "SoaDeque needs at least one field");
+
+ public:
+  using value_type = std::tuple<Fields...>;
+  using size_type = std::size_t;
+
+  template <std::size_t I>
+  using column_type = typename std::tuple_element<I, value_type>::type;
+
+  /// @brief Constructs an empty deque.
+  /// @param block_records number of records in one block
+  explicit SoaDeque(size_type block_records = 1024) : block_records(block_records ? block_records : 1) {}
+
+  SoaDeque(const SoaDeque&) = delete;
+  SoaDeque& operator=(const SoaDeque&) = delete;
+
+  /// @brief Returns the number of records in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no records
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Returns the number of slots in the block directory, including
+  /// the free ones before the first block.
+  size_type directory_slots() const noexcept{
+      return blocks.size();
+  }
+
+  /// @brief Returns a reference to field I of the record at pos. No bounds
+  /// checking is performed.
+  template <std::size_t I>
+  column_type<I>& get(size_type pos){
+      Block& block = locate(pos);
+      return std::get<I>(block.columns)[pos];
+  }
+
+  template <std::size_t I>
+  const column_type<I>& get(size_type pos) const{
+      return const_cast<SoaDeque*>(this)->template get<I>(pos);
+  }
+
+  /// @brief Same to get, with bounds checking.
+  /// @throw std::out_of_range
+  template <std::size_t I>
+  column_type<I>& at(size_type pos){
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return get<I>(pos);
+  }
+
+  template <std::size_t I>
+  const column_type<I>& at(size_type pos) const{
+      if(pos >= _size) throw std::out_of_range("index out of range");
+      return get<I>(pos);
+  }
+
+  /// @brief Returns a copy of the whole record at pos. No bounds checking is
+  /// performed.
+  value_type operator[](size_type pos) const{
+      Block& block = const_cast<SoaDeque*>(this)->locate(pos);
+      return load(block, pos, std::index_sequence_for<Fields...>());
+  }
+
+  /// @brief Returns a copy of the first record. Calling front on an empty
+  /// container is undefined.
+  value_type front() const{
+      return operator[](0);
+  }
+
+  /// @brief Returns a copy of the last record. Calling back on an empty
+  /// container is undefined.
+  value_type back() const{
+      return operator[](_size - 1);
+  }
+
+  /// @brief Appends a record to the end.
+  void push_back(const Fields&... values){
+      if(head == blocks.size() || blocks.back()->hi == block_records){
+          blocks.push_back(new_block(0));
+      }
+      Block& block = *blocks.back();
+      store(block, block.hi, std::forward_as_tuple(values...), std::index_sequence_for<Fields...>());
+      block.hi++;
+      _size++;
+  }
+
+  /// @brief Prepends a record to the beginning.
+  void push_front(const Fields&... values){
+      if(head == blocks.size() || blocks[head]->lo == 0){
+          if(head == 0) make_room_in_front();
+          blocks[--head] = new_block(block_records);
+      }
+      Block& block = *blocks[head];
+      store(block, block.lo - 1, std::forward_as_tuple(values...), std::index_sequence_for<Fields...>());
+      block.lo--;
+      _size++;
+  }
+
+  /// @brief Removes the last record. Calling pop_back on an empty container
+  /// is undefined.
+  void pop_back(){
+      Block& block = *blocks.back();
+      block.hi--;
+      _size--;
+      if(block.lo == block.hi){
+          recycle(std::move(blocks.back()));
+          blocks.pop_back();
+          if(blocks.size() == head) reset();
+      }
+  }
+
+  /// @brief Removes the first record. Calling pop_front on an empty container
+  /// is undefined.
+  void pop_front(){
+      Block& block = *blocks[head];
+      block.lo++;
+      _size--;
+      if(block.lo == block.hi){
+          recycle(std::move(blocks[head]));
+          head++;
+          //Освободившиеся места каталога перед head забираем, когда их больше половины.
+          if(blocks.size() == head) reset();
+          else if(head > blocks.size() / 2){
+              blocks.erase(blocks.begin(), blocks.begin() + head);
+              head = 0;
+          }
+      }
+  }
+
+  /// @brief Erases all records.
+  void clear() noexcept{
+      reset();
+      _size = 0;
+  }
+
+  /// @brief Calls f(data, count) for every contiguous run of field I, front
+  /// to back. data points to count values of the field.
+  template <std::size_t I, class F>
+  void for_each_span(F f){
+      for(size_type i = head; i < blocks.size(); i++){
+          Block& block = *blocks[i];
+          f(std::get<I>(block.columns).get() + block.lo, block.hi - block.lo);
+      }
+  }
+
+  template <std::size_t I, class F>
+  void for_each_span(F f) const{
+      for(size_type i = head; i < blocks.size(); i++){
+          const Block& block = *blocks[i];
+          f(static_cast<const column_type<I>*>(std::get<I>(block.columns).get() + block.lo), block.hi - block.lo);
+      }
+  }
+
+ private:
+  //Занятые позиции блока - [lo, hi) во всех столбцах сразу.
+  struct Block {
+      std::tuple<std::unique_ptr<Fields[]>...> columns;
+      size_type lo = 0;
+      size_type hi = 0;
+  };
+
+  std::unique_ptr<Block> new_block(size_type start){
+      std::unique_ptr<Block> block;
+      if(spare){
+          block = std::move(spare);
+      }
+      else{
+          block.reset(new Block);
+          block->columns = std::make_tuple(std::unique_ptr<Fields[]>(new Fields[block_records])...);
+      }
+      block->lo = start;
+      block->hi = start;
+      return block;
+  }
+
+  //Один освободившийся блок держим про запас, чтобы push/pop на границе блока не выделяли память.
+  void recycle(std::unique_ptr<Block> block){
+      spare = std::move(block);
+  }
+
+  template <class Values, std::size_t... I>
+  static void store(Block& block, size_type index, const Values& values, std::index_sequence<I...>){
+      int expand[] = {0, ((std::get<I>(block.columns)[index] = std::get<I>(values)), 0)...};
+      (void)expand;
+  }
+
+  template <std::size_t... I>
+  static value_type load(const Block& block, size_type index, std::index_sequence<I...>){
+      return value_type(std::get<I>(block.columns)[index]...);
+  }
+
+  //Находит блок записи pos и заменяет pos смещением в нем.
+  Block& locate(size_type& pos){
+      pos += blocks[head]->lo;
+      Block& block = *blocks[head + pos / block_records];
+      pos %= block_records;
+      return block;
+  }
+
+  //Сдвигаем занятые блоки вправо, чтобы перед head появилось место. Амортизированно O(1) на push_front.
+  void make_room_in_front(){
+      size_type used = blocks.size() - head;
+      size_type room = used > 4 ? used : 4;
+      std::vector<std::unique_ptr<Block>> moved(room + used);
+      std::move(blocks.begin() + head, blocks.end(), moved.begin() + room);
+      blocks.swap(moved);
+      head = room;
+  }
+
+  void reset() noexcept{
+      blocks.clear();
+      head = 0;
+  }
+
+  std::vector<std::unique_ptr<Block>> blocks; //Занята часть [head, blocks.size()).
+  std::unique_ptr<Block> spare;
+  size_type head = 0;
+  size_type _size = 0;
+  size_type block_records;
+};
+
+}  // namespace fefu_laboratory_two
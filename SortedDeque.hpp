@@ -0,0 +1,313 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace fefu_laboratory_two {
+
+// Упорядоченный дек: элементы всегда отсортированы по Compare (равные - в порядке вставки). Элементы лежат
+// в блоках по block_elements штук с запасом места с обеих сторон, каталог блоков упорядочен. Поиск - двоичный
+// поиск сначала по последним элементам блоков, потом внутри блока, т.е. O(log n). Вставка сдвигает
+// элементы блока с той стороны, где их меньше; полный блок делится пополам. Вставка нового максимума
+// или минимума сразу идет в крайний блок, без поиска.
+template <typename T, typename Compare = std::less<T>>
+class SortedDeque {
+  struct Block;
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+
+  //Позиция - номер блока и смещение в нем. Любая вставка или удаление делает итераторы недействительными.
+  class const_iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    reference operator*() const{
+        const Block& b = *owner->blocks[block];
+        return b.items[b.lo + offset];
+    }
+
+    pointer operator->() const{
+        return &operator*();
+    }
+
+    const_iterator& operator++(){
+        if(++offset == owner->blocks[block]->count()){
+            block++;
+            offset = 0;
+        }
+        return *this;
+    }
+
+    const_iterator operator++(int){
+        const_iterator temp(*this);
+        operator++();
+        return temp;
+    }
+
+    const_iterator& operator--(){
+        if(offset == 0){
+            block--;
+            offset = owner->blocks[block]->count();
+        }
+        offset--;
+        return *this;
+    }
+
+    const_iterator operator--(int){
+        const_iterator temp(*this);
+        operator--();
+        return temp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b){
+        return a.block == b.block && a.offset == b.offset;
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b){
+        return !(a == b);
+    }
+
+   private:
+    friend class SortedDeque;
+    const_iterator(const SortedDeque* owner, size_type block, size_type offset)
+        : owner(owner), block(block), offset(offset) {}
+
+    const SortedDeque* owner = nullptr;
+    size_type block = 0;
+    size_type offset = 0;
+  };
+
+  using iterator = const_iterator;
+
+  /// @brief Constructs an empty deque.
+  /// @param block_elements number of elements one block holds
+  explicit SortedDeque(size_type block_elements = 256, const Compare& compare = Compare())
+      : block_elements(block_elements > 1 ? block_elements : 2), less(compare) {}
+
+  SortedDeque(const SortedDeque&) = delete;
+  SortedDeque& operator=(const SortedDeque&) = delete;
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  const_iterator begin() const noexcept{
+      return const_iterator(this, 0, 0);
+  }
+
+  const_iterator end() const noexcept{
+      return const_iterator(this, blocks.size(), 0);
+  }
+
+  /// @brief Returns the smallest element. Calling front on an empty
+  /// container is undefined.
+  const_reference front() const{
+      const Block& b = *blocks.front();
+      return b.items[b.lo];
+  }
+
+  /// @brief Returns the largest element. Calling back on an empty container
+  /// is undefined.
+  const_reference back() const{
+      const Block& b = *blocks.back();
+      return b.items[b.hi - 1];
+  }
+
+  /// @brief First element not less than value. O(log n).
+  const_iterator lower_bound(const T& value) const{
+      return bound([&](const T& item){ return less(item, value); });
+  }
+
+  /// @brief First element greater than value. O(log n).
+  const_iterator upper_bound(const T& value) const{
+      return bound([&](const T& item){ return !less(value, item); });
+  }
+
+  /// @brief Range of elements equivalent to value. O(log n).
+  std::pair<const_iterator, const_iterator> equal_range(const T& value) const{
+      return {lower_bound(value), upper_bound(value)};
+  }
+
+  /// @brief Checks if an element equivalent to value is present.
+  bool contains(const T& value) const{
+      const_iterator it = lower_bound(value);
+      return it != end() && !less(value, *it);
+  }
+
+  /// @brief Inserts value after the elements equivalent to it. A new maximum
+  /// or minimum goes straight to the end block; otherwise O(log n + block
+  /// size).
+  void insert(const T& value){
+      if(blocks.empty() || !less(value, back())){
+          Block* b = blocks.empty() ? nullptr : blocks.back().get();
+          if(b == nullptr || b->hi == block_elements){
+              blocks.push_back(new_block(0));
+              b = blocks.back().get();
+          }
+          b->items[b->hi++] = value;
+          _size++;
+          return;
+      }
+      if(less(value, front())){
+          Block* b = blocks.front().get();
+          if(b->lo == 0){
+              blocks.insert(blocks.begin(), new_block(block_elements));
+              b = blocks.front().get();
+          }
+          b->items[--b->lo] = value;
+          _size++;
+          return;
+      }
+      const_iterator pos = upper_bound(value);
+      if(pos.block == blocks.size()){
+          pos.block--;
+          pos.offset = blocks[pos.block]->count();
+      }
+      insert_at(pos.block, pos.offset, value);
+  }
+
+  /// @brief Removes the element at pos.
+  void erase(const_iterator pos){
+      Block& b = *blocks[pos.block];
+      T* d = b.items.get();
+      size_type at = b.lo + pos.offset;
+      if(pos.offset < b.count() / 2){
+          std::move_backward(d + b.lo, d + at, d + at + 1);
+          b.lo++;
+      }
+      else{
+          std::move(d + at + 1, d + b.hi, d + at);
+          b.hi--;
+      }
+      _size--;
+      if(b.count() == 0) blocks.erase(blocks.begin() + pos.block);
+  }
+
+  /// @brief Removes one element equivalent to value.
+  /// @return false if there was none.
+  bool erase(const T& value){
+      const_iterator it = lower_bound(value);
+      if(it == end() || less(value, *it)) return false;
+      erase(it);
+      return true;
+  }
+
+  /// @brief Removes the smallest element. Calling pop_front on an empty
+  /// container is undefined.
+  void pop_front(){
+      erase(begin());
+  }
+
+  /// @brief Removes the largest element. Calling pop_back on an empty
+  /// container is undefined.
+  void pop_back(){
+      erase(const_iterator(this, blocks.size() - 1, blocks.back()->count() - 1));
+  }
+
+  /// @brief Erases all elements.
+  void clear() noexcept{
+      blocks.clear();
+      _size = 0;
+  }
+
+ private:
+  //Занятые позиции блока - [lo, hi) из block_elements.
+  struct Block {
+      std::unique_ptr<T[]> items;
+      size_type lo = 0;
+      size_type hi = 0;
+
+      size_type count() const noexcept{
+          return hi - lo;
+      }
+  };
+
+  std::unique_ptr<Block> new_block(size_type start) const{
+      std::unique_ptr<Block> b(new Block);
+      b->items.reset(new T[block_elements]);
+      b->lo = start;
+      b->hi = start;
+      return b;
+  }
+
+  //Первая позиция, для которой before(item) ложно: сначала блок по его последнему элементу, потом внутри блока.
+  template <class Before>
+  const_iterator bound(Before before) const{
+      auto block = std::partition_point(blocks.begin(), blocks.end(), [&](const std::unique_ptr<Block>& b){
+          return before(b->items[b->hi - 1]);
+      });
+      if(block == blocks.end()) return end();
+      const Block& b = **block;
+      const T* d = b.items.get();
+      const T* at = std::partition_point(d + b.lo, d + b.hi, before);
+      return const_iterator(this, static_cast<size_type>(block - blocks.begin()), static_cast<size_type>(at - (d + b.lo)));
+  }
+
+  //Вставка перед offset-м элементом блока: сдвигаем ту сторону, где элементов меньше; полный блок делим пополам.
+  void insert_at(size_type block, size_type offset, const T& value){
+      if(blocks[block]->count() == block_elements){
+          split(block);
+          size_type left = blocks[block]->count();
+          if(offset > left){
+              block++;
+              offset -= left;
+          }
+      }
+      Block& b = *blocks[block];
+      T* d = b.items.get();
+      size_type at = b.lo + offset;
+      bool shift_front = b.lo > 0 && (b.hi == block_elements || offset <= b.count() - offset);
+      if(shift_front){
+          std::move(d + b.lo, d + at, d + b.lo - 1);
+          b.lo--;
+          d[at - 1] = value;
+      }
+      else{
+          std::move_backward(d + at, d + b.hi, d + b.hi + 1);
+          b.hi++;
+          d[at] = value;
+      }
+      _size++;
+  }
+
+  //Верхняя половина полного блока переносится в новый блок, обе половины оказываются в середине своих блоков.
+  void split(size_type block){
+      Block& b = *blocks[block];
+      T* d = b.items.get();
+      size_type half = b.count() / 2;
+      size_type upper = b.count() - half;
+      std::unique_ptr<Block> next = new_block((block_elements - upper) / 2);
+      std::move(d + b.lo + half, d + b.hi, next->items.get() + next->lo);
+      next->hi = next->lo + upper;
+      size_type start = (block_elements - half) / 2;
+      std::move_backward(d + b.lo, d + b.lo + half, d + start + half);
+      b.lo = start;
+      b.hi = start + half;
+      blocks.insert(blocks.begin() + block + 1, std::move(next));
+  }
+
+  std::vector<std::unique_ptr<Block>> blocks;
+  size_type _size = 0;
+  size_type block_elements;
+  Compare less;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,340 @@
+#pragma once
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+// Дек с вытеснением на диск. Элементы лежат в блоках по block_elements штук, каталог блоков - обычный Deque.
+// Когда резидентные блоки занимают больше memory_budget байт, холодные блоки из середины записываются в файл
+// подкачки. Блоки у концов всегда в памяти, а вытесненные блоки, к которым приближаются pop_front/pop_back,
+// заранее читаются в фоне (readahead), поэтому операции на концах идут со скоростью памяти. Фоновые чтения
+// выполняет один поток, он запускается при первом readahead и берет запросы из очереди по порядку.
+// Только для тривиально копируемых T.
+template <typename T>
+class SpillDeque {
+  static_assert(std::is_trivially_copyable<T>::value, "SpillDeque needs a trivially copyable T");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  /// @brief Creates an empty deque with a spill file at spill_path. The file
+  /// is unlinked right after it is opened, so it disappears with the process.
+  /// @param spill_path where to create the spill file
+  /// @param memory_budget bytes of element storage to keep in memory
+  /// @param block_elements number of elements in one block
+  /// @param readahead_blocks how many blocks next to each end are kept in
+  /// memory and read back ahead of pops
+  /// @throw std::system_error if the spill file cannot be created
+  SpillDeque(const std::string& spill_path, size_type memory_budget, size_type block_elements = 4096,
+             size_type readahead_blocks = 2)
+      : memory_budget(memory_budget), block_elements(block_elements ? block_elements : 1),
+        readahead_blocks(readahead_blocks){
+      fd = ::open(spill_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+      if(fd < 0) throw std::system_error(errno, std::generic_category(), "SpillDeque: open " + spill_path);
+      ::unlink(spill_path.c_str());
+  }
+
+  SpillDeque(const SpillDeque&) = delete;
+  SpillDeque& operator=(const SpillDeque&) = delete;
+
+  //Останавливаем поток чтения (он дочитывает текущий блок, остальные запросы отбрасываются) и освобождаем
+  //сегменты.
+  ~SpillDeque(){
+      if(reader.joinable()){
+          {
+              std::lock_guard<std::mutex> guard(reader_lock);
+              stopping = true;
+          }
+          reader_wake.notify_one();
+          reader.join();
+      }
+      for(Node<Segment*>* cur = segments.first; cur != nullptr; cur = cur->next){
+          delete cur->value;
+      }
+      ::close(fd);
+  }
+
+  /// @brief Returns the number of elements in the container
+  size_type size() const noexcept{
+      return _size;
+  }
+
+  /// @brief Checks if the container has no elements
+  bool empty() const noexcept{
+      return _size == 0;
+  }
+
+  /// @brief Number of blocks held in memory.
+  size_type resident_blocks() const noexcept{
+      return resident;
+  }
+
+  /// @brief Number of blocks currently written out to the spill file.
+  size_type spilled_blocks() const noexcept{
+      return segments.size() - resident - loading;
+  }
+
+  /// @brief Returns a reference to the first element, reading its block back
+  /// if needed. Calling front on an empty container is undefined.
+  reference front(){
+      Block& block = resident_block(segments.front());
+      return block.items[block.lo];
+  }
+
+  /// @brief Returns a reference to the last element, reading its block back
+  /// if needed. Calling back on an empty container is undefined.
+  reference back(){
+      Block& block = resident_block(segments.back());
+      return block.items[block.hi - 1];
+  }
+
+  /// @brief Appends value to the end. May spill a cold block to disk.
+  /// @throw std::system_error if spilling fails
+  void push_back(const T& value){
+      if(segments.empty() || !segments.back()->block || segments.back()->block->hi == block_elements){
+          segments.push_back(new_segment(0));
+          enforce_budget();
+      }
+      Block& block = *segments.back()->block;
+      block.items[block.hi++] = value;
+      _size++;
+  }
+
+  /// @brief Prepends value to the beginning. May spill a cold block to disk.
+  /// @throw std::system_error if spilling fails
+  void push_front(const T& value){
+      if(segments.empty() || !segments.front()->block || segments.front()->block->lo == 0){
+          segments.push_front(new_segment(block_elements));
+          enforce_budget();
+      }
+      Block& block = *segments.front()->block;
+      block.items[--block.lo] = value;
+      _size++;
+  }
+
+  /// @brief Removes the first element and starts reading upcoming spilled
+  /// blocks. Calling pop_front on an empty container is undefined.
+  /// @throw std::system_error if reading a spilled block fails
+  void pop_front(){
+      Segment* segment = segments.front();
+      Block& block = resident_block(segment);
+      block.lo++;
+      _size--;
+      if(block.lo == block.hi){
+          resident--;
+          delete segment;
+          segments.pop_front();
+      }
+      read_ahead(segments.first, true);
+  }
+
+  /// @brief Removes the last element and starts reading upcoming spilled
+  /// blocks. Calling pop_back on an empty container is undefined.
+  /// @throw std::system_error if reading a spilled block fails
+  void pop_back(){
+      Segment* segment = segments.back();
+      Block& block = resident_block(segment);
+      block.hi--;
+      _size--;
+      if(block.lo == block.hi){
+          resident--;
+          delete segment;
+          segments.pop_back();
+      }
+      read_ahead(segments.last, false);
+  }
+
+ private:
+  struct Block {
+      std::unique_ptr<T[]> items;
+      size_type lo;
+      size_type hi;
+  };
+
+  //Сегмент - блок в памяти, блок, который сейчас читается, или место блока в файле подкачки.
+  struct Segment {
+      std::unique_ptr<Block> block;
+      std::future<std::unique_ptr<Block>> reading;
+      off_t offset = -1;
+      size_type lo = 0;
+      size_type hi = 0;
+  };
+
+  //Запрос потоку чтения: где лежит блок и куда отдать результат или исключение.
+  struct Read_request {
+      off_t offset;
+      size_type lo;
+      size_type hi;
+      std::promise<std::unique_ptr<Block>> result;
+  };
+
+  size_type block_bytes() const noexcept{
+      return block_elements * sizeof(value_type);
+  }
+
+  //Новый пустой блок, start - откуда он заполняется: 0 для push_back, block_elements для push_front.
+  Segment* new_segment(size_type start){
+      Segment* segment = new Segment;
+      segment->block.reset(new Block{std::unique_ptr<T[]>(new T[block_elements]), start, start});
+      resident++;
+      return segment;
+  }
+
+  //Пока блоки в памяти и блоки, которые читаются в фоне, не помещаются в бюджет, вытесняем резидентные блоки
+  //из середины, начиная с хвоста.
+  void enforce_budget(){
+      size_type hot = readahead_blocks + 1;
+      while((resident + loading) * block_bytes() > memory_budget){
+          size_type pos = segments.size();
+          Segment* victim = nullptr;
+          for(Node<Segment*>* cur = segments.last; cur != nullptr && --pos >= hot; cur = cur->previous){
+              if(pos + hot >= segments.size()) continue;
+              if(cur->value->block){
+                  victim = cur->value;
+                  break;
+              }
+          }
+          if(victim == nullptr) return;
+          spill(victim);
+      }
+  }
+
+  void spill(Segment* segment){
+      Block& block = *segment->block;
+      off_t offset;
+      if(free_offsets.empty()){
+          offset = file_end;
+          file_end += static_cast<off_t>(block_bytes());
+      }
+      else{
+          offset = free_offsets.back();
+          free_offsets.pop_back();
+      }
+      write_all(block.items.get() + block.lo, (block.hi - block.lo) * sizeof(value_type), offset);
+      segment->offset = offset;
+      segment->lo = block.lo;
+      segment->hi = block.hi;
+      segment->block.reset();
+      resident--;
+  }
+
+  //Блок сегмента в памяти: либо он уже там, либо дожидаемся фонового чтения, либо читаем сейчас.
+  Block& resident_block(Segment* segment){
+      if(segment->block) return *segment->block;
+      if(segment->reading.valid()){
+          //Чтение закончено, даже если get() бросит: тогда future станет пустым, и следующий вызов прочитает
+          //блок заново сам.
+          loading--;
+          segment->block = segment->reading.get();
+      }
+      else{
+          segment->block = read_block(fd, segment->offset, segment->lo, segment->hi, block_elements);
+      }
+      free_offsets.push_back(segment->offset);
+      segment->offset = -1;
+      resident++;
+      //segment на одном из концов, поэтому сам он не вытесняется.
+      enforce_budget();
+      return *segment->block;
+  }
+
+  //Запускает фоновое чтение вытесненных блоков среди readahead_blocks ближайших к концу, пока для них есть место
+  //в бюджете.
+  void read_ahead(Node<Segment*>* cur, bool forward){
+      for(size_type i = 0; i <= readahead_blocks && cur != nullptr; i++, cur = forward ? cur->next : cur->previous){
+          Segment* segment = cur->value;
+          if(segment->block || segment->reading.valid()) continue;
+          if((resident + loading + 1) * block_bytes() > memory_budget) return;
+          if(!reader.joinable()) reader = std::thread(&SpillDeque::reader_loop, this);
+          Read_request request{segment->offset, segment->lo, segment->hi, {}};
+          segment->reading = request.result.get_future();
+          {
+              std::lock_guard<std::mutex> guard(reader_lock);
+              requests.push_back(std::move(request));
+          }
+          reader_wake.notify_one();
+          loading++;
+      }
+  }
+
+  //Поток чтения: по одному забирает запросы из очереди и отдает прочитанный блок или ошибку через promise.
+  void reader_loop(){
+      for(;;){
+          std::unique_lock<std::mutex> guard(reader_lock);
+          reader_wake.wait(guard, [&]{ return stopping || !requests.empty(); });
+          if(stopping) return;
+          Read_request request = std::move(requests.front());
+          requests.pop_front();
+          guard.unlock();
+          try{
+              request.result.set_value(read_block(fd, request.offset, request.lo, request.hi, block_elements));
+          }
+          catch(...){
+              request.result.set_exception(std::current_exception());
+          }
+      }
+  }
+
+  static std::unique_ptr<Block> read_block(int fd, off_t offset, size_type lo, size_type hi, size_type capacity){
+      std::unique_ptr<Block> block(new Block{std::unique_ptr<T[]>(new T[capacity]), lo, hi});
+      char* dst = reinterpret_cast<char*>(block->items.get() + lo);
+      size_type bytes = (hi - lo) * sizeof(value_type);
+      while(bytes > 0){
+          ssize_t n = ::pread(fd, dst, bytes, offset);
+          if(n < 0 && errno == EINTR) continue;
+          if(n <= 0) throw std::system_error(n < 0 ? errno : EIO, std::generic_category(), "SpillDeque: pread");
+          dst += n;
+          offset += n;
+          bytes -= static_cast<size_type>(n);
+      }
+      return block;
+  }
+
+  void write_all(const void* data, size_type bytes, off_t offset){
+      const char* src = static_cast<const char*>(data);
+      while(bytes > 0){
+          ssize_t n = ::pwrite(fd, src, bytes, offset);
+          if(n < 0 && errno == EINTR) continue;
+          if(n < 0) throw std::system_error(errno, std::generic_category(), "SpillDeque: pwrite");
+          src += n;
+          offset += n;
+          bytes -= static_cast<size_type>(n);
+      }
+  }
+
+  Deque<Segment*> segments;
+  std::vector<off_t> free_offsets; //Освободившиеся места в файле подкачки, все размером с блок.
+  off_t file_end = 0;
+  int fd = -1;
+  size_type _size = 0;
+  size_type resident = 0;
+  size_type loading = 0;
+  size_type memory_budget;
+  size_type block_elements;
+  size_type readahead_blocks;
+  std::thread reader;
+  std::mutex reader_lock; //Защищает requests и stopping.
+  std::condition_variable reader_wake;
+  Deque<Read_request> requests;
+  bool stopping = false;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,352 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace fefu_laboratory_two {
+
+// Дек фиксированной емкости N без выделения памяти: элементы лежат в std::array внутри объекта,
+// как в кольцевом буфере. Все операции constexpr, поэтому один и тот же обобщенный код, написанный
+// под интерфейс Deque, работает и при компиляции (таблицы, конечные автоматы), и во время выполнения.
+// T должен быть литеральным типом с конструктором по умолчанию.
+template <typename T, std::size_t N>
+class StaticDeque {
+  static_assert(N > 0, "StaticDeque needs a non-zero capacity");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  //Итератор хранит номер элемента от начала, поэтому он произвольного доступа и не зависит от кольца.
+  template <typename Owner, typename U>
+  class basic_iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U*;
+    using reference = U&;
+
+    constexpr basic_iterator() = default;
+
+    //Из iterator можно получить const_iterator, но не наоборот.
+    template <typename OtherOwner, typename V,
+              typename = std::enable_if_t<std::is_convertible<OtherOwner*, Owner*>::value>>
+    constexpr basic_iterator(const basic_iterator<OtherOwner, V>& other) : owner(other.owner), pos(other.pos) {}
+
+    constexpr reference operator*() const{
+        return (*owner)[pos];
+    }
+
+    constexpr pointer operator->() const{
+        return &(*owner)[pos];
+    }
+
+    constexpr reference operator[](difference_type n) const{
+        return (*owner)[pos + n];
+    }
+
+    constexpr basic_iterator& operator++(){
+        pos++;
+        return *this;
+    }
+
+    constexpr basic_iterator operator++(int){
+        basic_iterator temp(*this);
+        pos++;
+        return temp;
+    }
+
+    constexpr basic_iterator& operator--(){
+        pos--;
+        return *this;
+    }
+
+    constexpr basic_iterator operator--(int){
+        basic_iterator temp(*this);
+        pos--;
+        return temp;
+    }
+
+    constexpr basic_iterator& operator+=(difference_type n){
+        pos += n;
+        return *this;
+    }
+
+    constexpr basic_iterator& operator-=(difference_type n){
+        pos -= n;
+        return *this;
+    }
+
+    friend constexpr basic_iterator operator+(basic_iterator a, difference_type n){
+        return a += n;
+    }
+
+    friend constexpr basic_iterator operator+(difference_type n, basic_iterator a){
+        return a += n;
+    }
+
+    friend constexpr basic_iterator operator-(basic_iterator a, difference_type n){
+        return a -= n;
+    }
+
+    friend constexpr difference_type operator-(const basic_iterator& a, const basic_iterator& b){
+        return a.pos - b.pos;
+    }
+
+    friend constexpr bool operator==(const basic_iterator& a, const basic_iterator& b){
+        return a.pos == b.pos;
+    }
+
+    friend constexpr bool operator!=(const basic_iterator& a, const basic_iterator& b){
+        return a.pos != b.pos;
+    }
+
+    friend constexpr bool operator<(const basic_iterator& a, const basic_iterator& b){
+        return a.pos < b.pos;
+    }
+
+    friend constexpr bool operator<=(const basic_iterator& a, const basic_iterator& b){
+        return a.pos <= b.pos;
+    }
+
+    friend constexpr bool operator>(const basic_iterator& a, const basic_iterator& b){
+        return a.pos > b.pos;
+    }
+
+    friend constexpr bool operator>=(const basic_iterator& a, const basic_iterator& b){
+        return a.pos >= b.pos;
+    }
+
+   private:
+    friend class StaticDeque;
+    template <typename OtherOwner, typename V>
+    friend class basic_iterator;
+
+    constexpr basic_iterator(Owner* owner, difference_type pos) : owner(owner), pos(pos) {}
+
+    Owner* owner = nullptr;
+    difference_type pos = 0;
+  };
+
+  using iterator = basic_iterator<StaticDeque, T>;
+  using const_iterator = basic_iterator<const StaticDeque, const T>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  constexpr StaticDeque() = default;
+
+  /// @brief Constructs the container with the contents of init.
+  /// @throw std::length_error if init has more than N elements
+  constexpr StaticDeque(std::initializer_list<T> init){
+      for(const T& value : init) push_back(value);
+  }
+
+  /// @brief Returns the number of elements in the container
+  constexpr size_type size() const noexcept{
+      return count;
+  }
+
+  /// @brief Checks if the container has no elements
+  constexpr bool empty() const noexcept{
+      return count == 0;
+  }
+
+  /// @brief Checks if the container holds N elements
+  constexpr bool full() const noexcept{
+      return count == N;
+  }
+
+  /// @brief Returns the fixed capacity N
+  static constexpr size_type max_size() noexcept{
+      return N;
+  }
+
+  constexpr iterator begin() noexcept{
+      return iterator(this, 0);
+  }
+
+  constexpr const_iterator begin() const noexcept{
+      return const_iterator(this, 0);
+  }
+
+  constexpr const_iterator cbegin() const noexcept{
+      return begin();
+  }
+
+  constexpr iterator end() noexcept{
+      return iterator(this, static_cast<difference_type>(count));
+  }
+
+  constexpr const_iterator end() const noexcept{
+      return const_iterator(this, static_cast<difference_type>(count));
+  }
+
+  constexpr const_iterator cend() const noexcept{
+      return end();
+  }
+
+  constexpr reverse_iterator rbegin() noexcept{
+      return reverse_iterator(end());
+  }
+
+  constexpr const_reverse_iterator rbegin() const noexcept{
+      return const_reverse_iterator(end());
+  }
+
+  constexpr reverse_iterator rend() noexcept{
+      return reverse_iterator(begin());
+  }
+
+  constexpr const_reverse_iterator rend() const noexcept{
+      return const_reverse_iterator(begin());
+  }
+
+  /// @brief Returns a reference to the element at pos. No bounds checking is
+  /// performed.
+  constexpr reference operator[](size_type pos){
+      return items[slot(pos)];
+  }
+
+  constexpr const_reference operator[](size_type pos) const{
+      return items[slot(pos)];
+  }
+
+  /// @brief Same to operator[], with bounds checking.
+  /// @throw std::out_of_range
+  constexpr reference at(size_type pos){
+      if(pos >= count) throw std::out_of_range("index out of range");
+      return items[slot(pos)];
+  }
+
+  constexpr const_reference at(size_type pos) const{
+      if(pos >= count) throw std::out_of_range("index out of range");
+      return items[slot(pos)];
+  }
+
+  /// @brief Calling front on an empty container is undefined.
+  constexpr reference front(){
+      return items[head];
+  }
+
+  constexpr const_reference front() const{
+      return items[head];
+  }
+
+  /// @brief Calling back on an empty container is undefined.
+  constexpr reference back(){
+      return items[slot(count - 1)];
+  }
+
+  constexpr const_reference back() const{
+      return items[slot(count - 1)];
+  }
+
+  /// @brief Appends value to the end.
+  /// @throw std::length_error if the container is full
+  constexpr void push_back(const T& value){
+      check_room();
+      items[slot(count)] = value;
+      count++;
+  }
+
+  constexpr void push_back(T&& value){
+      check_room();
+      items[slot(count)] = std::move(value);
+      count++;
+  }
+
+  /// @brief Constructs an element at the end from args.
+  /// @throw std::length_error if the container is full
+  template <class... Args>
+  constexpr reference emplace_back(Args&&... args){
+      push_back(T(std::forward<Args>(args)...));
+      return back();
+  }
+
+  /// @brief Prepends value to the beginning.
+  /// @throw std::length_error if the container is full
+  constexpr void push_front(const T& value){
+      check_room();
+      head = head == 0 ? N - 1 : head - 1;
+      items[head] = value;
+      count++;
+  }
+
+  constexpr void push_front(T&& value){
+      check_room();
+      head = head == 0 ? N - 1 : head - 1;
+      items[head] = std::move(value);
+      count++;
+  }
+
+  /// @brief Constructs an element at the beginning from args.
+  /// @throw std::length_error if the container is full
+  template <class... Args>
+  constexpr reference emplace_front(Args&&... args){
+      push_front(T(std::forward<Args>(args)...));
+      return front();
+  }
+
+  /// @brief Removes the last element. Calling pop_back on an empty container
+  /// is undefined.
+  constexpr void pop_back(){
+      items[slot(count - 1)] = T();
+      count--;
+  }
+
+  /// @brief Removes the first element. Calling pop_front on an empty
+  /// container is undefined.
+  constexpr void pop_front(){
+      items[head] = T();
+      head = head + 1 == N ? 0 : head + 1;
+      count--;
+  }
+
+  /// @brief Erases all elements.
+  constexpr void clear(){
+      while(count > 0) pop_back();
+      head = 0;
+  }
+
+  constexpr void swap(StaticDeque& other){
+      StaticDeque temp = *this;
+      *this = other;
+      other = temp;
+  }
+
+  friend constexpr bool operator==(const StaticDeque& lhs, const StaticDeque& rhs){
+      if(lhs.count != rhs.count) return false;
+      for(size_type i = 0; i < lhs.count; i++){
+          if(!(lhs[i] == rhs[i])) return false;
+      }
+      return true;
+  }
+
+  friend constexpr bool operator!=(const StaticDeque& lhs, const StaticDeque& rhs){
+      return !(lhs == rhs);
+  }
+
+ private:
+  constexpr size_type slot(size_type pos) const noexcept{
+      size_type i = head + pos;
+      return i >= N ? i - N : i;
+  }
+
+  constexpr void check_room() const{
+      if(count == N) throw std::length_error("StaticDeque is full");
+  }
+
+  std::array<T, N> items{};
+  size_type head = 0;
+  size_type count = 0;
+};
+
+}  // namespace fefu_laboratory_two
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+#include "Deque.hpp"
+
+namespace fefu_laboratory_two {
+
+/// @brief Minimum as an aggregation operator. WindowAggregator keeps a
+/// monotonic deque for it instead of the generic two-stacks scheme.
+template <typename T>
+struct WindowMin {
+    const T& operator()(const T& a, const T& b) const{
+        return b < a ? b : a;
+    }
+};
+
+/// @brief Maximum as an aggregation operator, see WindowMin.
+template <typename T>
+struct WindowMax {
+    const T& operator()(const T& a, const T& b) const{
+        return a < b ? b : a;
+    }
+};
+
+// Агрегат по скользящему окну: push добавляет новый элемент, evict убирает самый старый, query возвращает
+// свертку всего окна оператором Op за O(1). Для любого ассоциативного Op используется схема двух стеков
+// в одном Deque: у элементов передней части хранится свертка от них до конца этой части, у задней части
+// хранится общая свертка back_aggregate. Когда передняя часть кончается, свертки пересчитываются за один
+// проход, поэтому push и evict - амортизированно O(1), а Op вызывается не больше трех раз на элемент.
+template <typename T, typename Op = std::plus<T>>
+class WindowAggregator {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  explicit WindowAggregator(Op op = Op()) : op(op) {}
+
+  /// @brief Returns the number of elements in the window
+  size_type size() const noexcept{
+      return entries.size();
+  }
+
+  /// @brief Checks if the window has no elements
+  bool empty() const noexcept{
+      return entries.empty();
+  }
+
+  /// @brief Adds value as the newest element of the window.
+  void push(const T& value){
+      entries.push_back(Entry{value, value});
+      back_aggregate = entries.size() - 1 == front_count ? value : op(back_aggregate, value);
+  }
+
+  /// @brief Removes the oldest element of the window. Calling evict on an
+  /// empty window is undefined.
+  void evict(){
+      if(front_count == 0) flip();
+      entries.pop_front();
+      front_count--;
+  }
+
+  /// @brief Returns the aggregate of the whole window, oldest to newest.
+  /// Calling query on an empty window is undefined.
+  value_type query() const{
+      if(front_count == 0) return back_aggregate;
+      if(front_count == entries.size()) return entries.front().aggregate;
+      return op(entries.front().aggregate, back_aggregate);
+  }
+
+ private:
+  struct Entry {
+      T value;
+      T aggregate;
+  };
+
+  //Все элементы переходят в переднюю часть: свертки считаются с конца, от каждого элемента до последнего.
+  void flip(){
+      Node<Entry>* cur = entries.last;
+      cur->value.aggregate = cur->value.value;
+      for(Node<Entry>* prev = cur->previous; prev != nullptr; cur = prev, prev = prev->previous){
+          prev->value.aggregate = op(prev->value.value, cur->value.aggregate);
+      }
+      front_count = entries.size();
+  }
+
+  Deque<Entry> entries;
+  size_type front_count = 0; //Первые front_count элементов хранят свертки до конца передней части.
+  T back_aggregate = T(); //Свертка остальных элементов.
+  Op op;
+};
+
+// Минимум и максимум окна - монотонный дек: хранятся только кандидаты, которые еще могут стать ответом,
+// по возрастанию (для минимума) от старых к новым. Новый элемент выталкивает с конца всех, кто не лучше него.
+// Элементы нумеруются, чтобы evict узнавал, уходит ли из окна текущий ответ.
+template <typename T, typename Compare>
+class Monotonic_window {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  /// @brief Returns the number of elements in the window
+  size_type size() const noexcept{
+      return static_cast<size_type>(pushed - evicted);
+  }
+
+  /// @brief Checks if the window has no elements
+  bool empty() const noexcept{
+      return pushed == evicted;
+  }
+
+  /// @brief Adds value as the newest element of the window.
+  void push(const T& value){
+      while(!candidates.empty() && !better(candidates.back().value, value)) candidates.pop_back();
+      candidates.push_back(Candidate{value, pushed++});
+  }
+
+  /// @brief Removes the oldest element of the window. Calling evict on an
+  /// empty window is undefined.
+  void evict(){
+      if(candidates.front().seq == evicted) candidates.pop_front();
+      evicted++;
+  }
+
+  /// @brief Returns the minimum (maximum) of the window. Calling query on an
+  /// empty window is undefined.
+  value_type query() const{
+      return candidates.front().value;
+  }
+
+ private:
+  struct Candidate {
+      T value;
+      std::uint64_t seq;
+  };
+
+  //Строгое сравнение: равный старый кандидат вытесняется новым, он уйдет из окна раньше.
+  bool better(const T& a, const T& b) const{
+      return Compare()(a, b);
+  }
+
+  Deque<Candidate> candidates;
+  std::uint64_t pushed = 0;
+  std::uint64_t evicted = 0;
+};
+
+template <typename T>
+class WindowAggregator<T, WindowMin<T>> : public Monotonic_window<T, std::less<T>> {
+ public:
+  explicit WindowAggregator(WindowMin<T> = WindowMin<T>()) {}
+};
+
+template <typename T>
+class WindowAggregator<T, WindowMax<T>> : public Monotonic_window<T, std::greater<T>> {
+ public:
+  explicit WindowAggregator(WindowMax<T> = WindowMax<T>()) {}
+};
+
+}  // namespace fefu_laboratory_two
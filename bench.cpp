@@ -0,0 +1,404 @@
+// Замеры производительности контейнеров библиотеки. Не входит в ctest: числа зависят от машины и диска.
+// Собирать с -DCMAKE_BUILD_TYPE=Release. Запуск: ./labtwo_bench - все разделы, ./labtwo_bench journal ... - только
+// перечисленные разделы.
+// Каждая строка вывода - раздел, вариант и результат, чтобы прогоны на разных машинах было удобно сравнивать.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ratio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CompressedDeque.hpp"
+#include "Deque.hpp"
+#include "IntrusiveDeque.hpp"
+#include "JournaledDeque.hpp"
+#include "LruCache.hpp"
+#include "SharedDeque.hpp"
+
+using namespace fefu_laboratory_two;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+double seconds_since(bench_clock::time_point start){
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+void report(const char* section, const std::string& variant, const char* what, double value){
+    std::printf("%-12s %-52s %14.1f %s\n", section, variant.c_str(), value, what);
+    std::fflush(stdout);
+}
+
+//Каталог для файлов дисковых контейнеров, удаляется в конце прогона.
+std::string scratch_dir(){
+    static std::string dir = []{
+        char templ[] = "/tmp/labtwo_bench_XXXXXX";
+        if(::mkdtemp(templ) == nullptr) std::abort();
+        return std::string(templ);
+    }();
+    return dir;
+}
+
+//Дек из count узлов, разбросанных по памяти: сначала count узлов выделяется в другом деке, они освобождаются
+//в случайном порядке, и новые узлы получают освобождённые адреса вперемешку.
+Deque<long> scattered_deque(std::size_t count){
+    Deque<long> filler;
+    std::vector<Deque<long>::iterator> order;
+    order.reserve(count);
+    for(std::size_t i = 0; i < count; i++){
+        filler.push_back(static_cast<long>(i));
+        order.push_back(--filler.end());
+    }
+    std::uint64_t state = 88172645463325252ull;
+    for(std::size_t i = count - 1; i > 0; i--){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::swap(order[i], order[state % (i + 1)]);
+    }
+    for(Deque<long>::iterator& it : order) filler.erase(it);
+    Deque<long> scattered;
+    for(std::size_t i = 0; i < count; i++) scattered.push_back(static_cast<long>(i));
+    return scattered;
+}
+
+//Проход по раздробленному деку против того же дека после compact() и после серии compact(4096).
+void bench_compact(){
+    const int passes = 10;
+    long sum = 0;
+    for(std::size_t count : {std::size_t(10000), std::size_t(1000000)}){
+        auto walk = [&](const Deque<long>& deque){
+            bench_clock::time_point start = bench_clock::now();
+            for(int pass = 0; pass < passes; pass++){
+                for(long value : deque) sum += value;
+            }
+            return passes * count / seconds_since(start) / 1e6;
+        };
+        std::string size = std::to_string(count) + " nodes";
+
+        Deque<long> deque = scattered_deque(count);
+        report("compact", size + ", fragmentation " + std::to_string(deque.fragmentation()), "M nodes/s", walk(deque));
+        bench_clock::time_point start = bench_clock::now();
+        deque.compact();
+        report("compact", size + ", compact()", "ms", seconds_since(start) * 1e3);
+        report("compact", size + ", walk after compact()", "M nodes/s", walk(deque));
+
+        deque = scattered_deque(count);
+        start = bench_clock::now();
+        while(!deque.compact(4096)){}
+        report("compact", size + ", compact(4096) until done", "ms", seconds_since(start) * 1e3);
+        report("compact", size + ", walk after compact(4096)", "M nodes/s", walk(deque));
+    }
+    if(sum == 0) std::puts("");
+}
+
+//Долговечные операции в секунду: writers потоков делают push_back с ожиданием fdatasync, так что одна запись
+//журнала на диск покрывает до writers операций (group commit). Чем больше писателей, тем больше пачка.
+void bench_journal(){
+    const int per_writer = 2000;
+    for(int writers : {1, 4, 16}){
+        for(long interval_us : {100L, 1000L}){
+            std::string path = scratch_dir() + "/journal_" + std::to_string(writers) + "_" + std::to_string(interval_us);
+            JournaledDeque<long> journal(path, std::chrono::microseconds(interval_us));
+            bench_clock::time_point start = bench_clock::now();
+            std::vector<std::thread> threads;
+            for(int w = 0; w < writers; w++){
+                threads.emplace_back([&journal, w]{
+                    for(int i = 0; i < per_writer; i++) journal.push_back(static_cast<long>(w) * per_writer + i);
+                });
+            }
+            for(std::thread& t : threads) t.join();
+            double elapsed = seconds_since(start);
+            report("journal", std::to_string(writers) + " writers, commit every " + std::to_string(interval_us) + "us",
+                   "durable ops/s", writers * per_writer / elapsed);
+        }
+    }
+}
+
+//Потребитель в дочернем процессе забирает messages чисел и сообщает через код выхода, сошлась ли сумма.
+template <class Consume>
+bool run_consumer_process(int messages, Consume consume, pid_t& child){
+    child = ::fork();
+    if(child < 0) return false;
+    if(child == 0){
+        long sum = 0;
+        for(int i = 0; i < messages; i++) sum += consume();
+        ::_exit(sum == static_cast<long>(messages) * (messages - 1) / 2 ? 0 : 1);
+    }
+    return true;
+}
+
+bool wait_consumer(pid_t child){
+    int status = 0;
+    return ::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//Два процесса передают messages чисел по одному: через SharedDeque (без системных вызовов, пока никто не спит)
+//и через pipe, где каждое сообщение - один write и один read.
+void bench_shared(){
+    const int messages = 500000;
+    std::string name = "/labtwo_bench_" + std::to_string(::getpid());
+    {
+        SharedDeque<long> producer(name, 4096);
+        bench_clock::time_point start = bench_clock::now();
+        pid_t child;
+        bool started = run_consumer_process(messages, [&name]{
+            static SharedDeque<long> consumer(name);
+            return consumer.pop_front();
+        }, child);
+        if(started){
+            for(int i = 0; i < messages; i++) producer.push_back(i);
+            bool ok = wait_consumer(child);
+            report("shared", ok ? "SharedDeque, ring of 4096" : "SharedDeque, ring of 4096 (FAILED)", "messages/s",
+                   messages / seconds_since(start));
+        }
+    }
+    SharedDeque<long>::unlink(name);
+
+    int fds[2];
+    if(::pipe(fds) != 0) return;
+    bench_clock::time_point start = bench_clock::now();
+    pid_t child;
+    bool started = run_consumer_process(messages, [&fds]{
+        long value = 0;
+        char* dst = reinterpret_cast<char*>(&value);
+        size_t got = 0;
+        while(got < sizeof(value)){
+            ssize_t n = ::read(fds[0], dst + got, sizeof(value) - got);
+            if(n <= 0) ::_exit(1);
+            got += static_cast<size_t>(n);
+        }
+        return value;
+    }, child);
+    if(started){
+        for(long i = 0; i < messages; i++){
+            if(::write(fds[1], &i, sizeof(i)) != static_cast<ssize_t>(sizeof(i))) break;
+        }
+        bool ok = wait_consumer(child);
+        report("shared", ok ? "pipe, one write per message" : "pipe, one write per message (FAILED)", "messages/s",
+               messages / seconds_since(start));
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+//Память и скорость распаковки CompressedDeque на монотонных метках времени с шагом 1..1024 мкс
+//по сравнению с плоским массивом int64_t и с узлами Deque.
+void bench_compressed(){
+    const std::size_t count = 4000000;
+    std::uint64_t state = 88172645463325252ull;
+    CompressedDeque<std::int64_t> stamps;
+    std::int64_t stamp = 1700000000000000;
+    for(std::size_t i = 0; i < count; i++){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        stamp += 1 + static_cast<std::int64_t>(state & 1023);
+        stamps.push_back(stamp);
+    }
+    double raw = static_cast<double>(count * sizeof(std::int64_t));
+    double nodes = static_cast<double>(count * sizeof(Node<std::int64_t>));
+    double used = static_cast<double>(stamps.memory_usage());
+    report("compressed", "bytes per element", "B", used / count);
+    report("compressed", "raw int64_t array / compressed", "x", raw / used);
+    report("compressed", "Deque<int64_t> nodes / compressed", "x", nodes / used);
+
+    std::int64_t sum = 0;
+    bench_clock::time_point start = bench_clock::now();
+    stamps.for_each([&sum](std::int64_t value){ sum += value; });
+    report("compressed", "for_each decode", "M values/s", count / seconds_since(start) / 1e6);
+
+    const std::size_t lookups = 20000;
+    start = bench_clock::now();
+    for(std::size_t i = 0; i < lookups; i++){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        sum += stamps[state % count];
+    }
+    report("compressed", "operator[] at random positions", "K lookups/s", lookups / seconds_since(start) / 1e3);
+    if(sum == 0) std::puts("");
+}
+
+struct Message {
+    long id = 0;
+    char payload[48] = {};
+    IntrusiveHook<Message> hook;
+};
+
+//Очередь сообщений из пула: IntrusiveDeque связывает сами объекты, Deque<Message*> выделяет по узлу на push.
+//Второй замер - удаление сообщения из середины очереди по указателю на него.
+void bench_intrusive(){
+    const std::size_t depth = 1024;
+    const std::size_t rounds = 2000000;
+    std::vector<Message> pool(depth);
+    for(std::size_t i = 0; i < depth; i++) pool[i].id = static_cast<long>(i);
+    long sum = 0;
+
+    IntrusiveDeque<Message, &Message::hook> intrusive;
+    for(Message& message : pool) intrusive.push_back(message);
+    bench_clock::time_point start = bench_clock::now();
+    for(std::size_t i = 0; i < rounds; i++){
+        Message& message = intrusive.front();
+        intrusive.pop_front();
+        sum += message.id;
+        intrusive.push_back(message);
+    }
+    report("intrusive", "IntrusiveDeque pop_front + push_back", "M ops/s", rounds / seconds_since(start) / 1e6);
+
+    Deque<Message*> pointers;
+    for(Message& message : pool) pointers.push_back(&message);
+    start = bench_clock::now();
+    for(std::size_t i = 0; i < rounds; i++){
+        Message* message = pointers.front();
+        pointers.pop_front();
+        sum += message->id;
+        pointers.push_back(message);
+    }
+    report("intrusive", "Deque<Message*> pop_front + push_back", "M ops/s", rounds / seconds_since(start) / 1e6);
+
+    //Случайные позиции, чтобы поиск в Deque<Message*> в среднем проходил половину очереди.
+    const std::size_t removals = 20000;
+    std::vector<std::size_t> victims(removals);
+    std::uint64_t state = 88172645463325252ull;
+    for(std::size_t& victim : victims){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        victim = state % depth;
+    }
+    start = bench_clock::now();
+    for(std::size_t victim : victims){
+        Message& message = pool[victim];
+        intrusive.erase(message);
+        intrusive.push_back(message);
+    }
+    report("intrusive", "IntrusiveDeque erase(object) + push_back", "K ops/s", removals / seconds_since(start) / 1e3);
+
+    start = bench_clock::now();
+    for(std::size_t victim : victims){
+        Message* message = &pool[victim];
+        pointers.erase(pointers.get_iter(message));
+        pointers.push_back(message);
+    }
+    report("intrusive", "Deque<Message*> get_iter + erase + push_back", "K ops/s", removals / seconds_since(start) / 1e3);
+    if(sum == 0) std::puts("");
+}
+
+//Кэш на 4096 записей: 80% обращений - к 3000 горячим ключам, 20% - сквозной проход по миллиону ключей,
+//который вымывает горячие записи из простого LRU. Промах дозаписывает значение через put.
+void bench_lru(){
+    const std::size_t accesses = 2000000;
+    std::vector<long> keys(accesses);
+    std::uint64_t state = 88172645463325252ull;
+    long scan = 1000000;
+    for(long& key : keys){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        key = state % 10 < 8 ? static_cast<long>(state / 10 % 3000) : scan++;
+    }
+    for(std::size_t protected_capacity : {std::size_t(0), std::size_t(3072)}){
+        LruCache<long, long> cache(4096, protected_capacity);
+        bench_clock::time_point start = bench_clock::now();
+        for(long key : keys){
+            if(cache.get(key) == nullptr) cache.put(key, key);
+        }
+        double elapsed = seconds_since(start);
+        std::string variant = protected_capacity == 0 ? "LRU, 4096 entries" : "SLRU, 4096 entries, 3072 protected";
+        report("lru", variant, "% hits", cache.hit_rate() * 100);
+        report("lru", variant, "M accesses/s", accesses / elapsed / 1e6);
+    }
+}
+
+//Один и тот же набор замеров для Deque с политикой Policy: очередь push_back + pop_front, operator[] у начала
+//дека, проход по раздробленному деку до и после compact(step) блоками Policy::chunk_nodes.
+template <class Policy>
+void bench_policy(const char* variant){
+    using PolicyDeque = Deque<long, Allocator<Node<long>>, Policy>;
+    const std::size_t operations = 2000000;
+    long sum = 0;
+
+    PolicyDeque queue;
+    for(long i = 0; i < 1024; i++) queue.push_back(i);
+    bench_clock::time_point start = bench_clock::now();
+    for(std::size_t i = 0; i < operations; i++){
+        sum += queue.front();
+        queue.pop_front();
+        queue.push_back(static_cast<long>(i));
+    }
+    report("policy", std::string(variant) + ": pop_front + push_back", "M ops/s", operations / seconds_since(start) / 1e6);
+
+    start = bench_clock::now();
+    for(std::size_t i = 0; i < operations; i++) sum += queue[i % 16];
+    report("policy", std::string(variant) + ": operator[] near front", "M ops/s", operations / seconds_since(start) / 1e6);
+
+    //Узлы вперемешку с узлами другого дека, чтобы соседние элементы не лежали рядом в памяти.
+    const std::size_t count = 200000;
+    PolicyDeque scattered;
+    {
+        Deque<long> filler;
+        for(std::size_t i = 0; i < count; i++){
+            scattered.push_back(static_cast<long>(i));
+            filler.push_back(static_cast<long>(i));
+        }
+    }
+    auto walk = [&]{
+        const int passes = 10;
+        bench_clock::time_point begin = bench_clock::now();
+        for(int pass = 0; pass < passes; pass++){
+            for(Node<long>* cur = scattered.first; cur != nullptr; cur = cur->next) sum += cur->value;
+        }
+        return passes * count / seconds_since(begin) / 1e6;
+    };
+    report("policy", std::string(variant) + ": walk scattered nodes", "M nodes/s", walk());
+    start = bench_clock::now();
+    while(!scattered.compact(4096)){}
+    report("policy", std::string(variant) + ": compact(4096) until done", "ms", seconds_since(start) * 1e3);
+    report("policy", std::string(variant) + ": walk after compact", "M nodes/s", walk());
+    if(sum == 0) std::puts("");
+}
+
+//Сравнение сочетаний Deque_policy: по умолчанию, с проверкой индекса, со статистикой и с разными блоками compact.
+void bench_policies(){
+    bench_policy<Deque_policy<>>("default");
+    bench_policy<Deque_policy<0, std::ratio<1>, true>>("checked index");
+    bench_policy<Deque_policy<0, std::ratio<1>, false, true>>("statistics");
+    bench_policy<Deque_policy<64, std::ratio<2>>>("chunks 64 nodes, growth 2");
+    bench_policy<Deque_policy<4096, std::ratio<3, 2>>>("chunks 4096 nodes, growth 3/2");
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+const Section sections[] = {
+    {"compact", bench_compact},
+    {"journal", bench_journal},
+    {"shared", bench_shared},
+    {"compressed", bench_compressed},
+    {"intrusive", bench_intrusive},
+    {"lru", bench_lru},
+    {"policy", bench_policies},
+};
+
+}  // namespace
+
+int main(int argc, char** argv){
+    for(const Section& section : sections){
+        bool wanted = argc < 2;
+        for(int i = 1; i < argc; i++) wanted = wanted || std::strcmp(argv[i], section.name) == 0;
+        if(wanted) section.run();
+    }
+    std::string cleanup = "rm -rf " + scratch_dir();
+    return std::system(cleanup.c_str()) == 0 ? 0 : 1;
+}
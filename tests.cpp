@@ -0,0 +1,2172 @@
+// Проверки контейнеров библиотеки: каждый заголовок инстанцируется хотя бы одним тестом, чтобы сборка
+// ловила ошибки компиляции шаблонов, плюс проверки граничных случаев. Запуск - ctest или ./labtwo_tests.
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <ratio>
+#include <set>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ByteDeque.hpp"
+#include "CompressedDeque.hpp"
+#include "CowDeque.hpp"
+#include "Deque.hpp"
+#include "ExpiringDeque.hpp"
+#include "HashIndex.hpp"
+#include "IndexedDeque.hpp"
+#include "IntrusiveDeque.hpp"
+#include "JournaledDeque.hpp"
+#include "LogDeque.hpp"
+#include "LruCache.hpp"
+#include "MappedDeque.hpp"
+#include "MinMaxPriorityDeque.hpp"
+#include "PackedDeque.hpp"
+#include "PersistentDeque.hpp"
+#include "RecordDeque.hpp"
+#include "SharedDeque.hpp"
+#include "SoaDeque.hpp"
+#include "SortedDeque.hpp"
+#include "SpillDeque.hpp"
+#include "StaticDeque.hpp"
+#include "WindowAggregator.hpp"
+
+using namespace fefu_laboratory_two;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                               \
+    do{                                                                           \
+        if(!(cond)){                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                           \
+        }                                                                         \
+    } while(0)
+
+//Каталог для файлов дисковых контейнеров, удаляется в конце прогона.
+std::string scratch_dir(){
+    static std::string dir = []{
+        char templ[] = "/tmp/labtwo_tests_XXXXXX";
+        if(::mkdtemp(templ) == nullptr) std::abort();
+        return std::string(templ);
+    }();
+    return dir;
+}
+
+template <class D>
+std::deque<int> contents(const D& d){
+    std::deque<int> out;
+    for(Node<int>* cur = d.first; cur != nullptr; cur = cur->next) out.push_back(cur->value);
+    return out;
+}
+
+void test_deque(){
+    Deque<int> d;
+    for(int i = 0; i < 10; i++) d.push_back(i);
+    d.push_front(-1);
+    CHECK(d.size() == 11);
+    CHECK(d.front() == -1 && d.back() == 9);
+    CHECK(d.at(3) == 2);
+    d.rotate(3);
+    CHECK(d.front() == 2);
+    Deque<int> tail = d.split_at(5);
+    CHECK(d.size() == 5 && tail.size() == 6);
+    d.append(std::move(tail));
+    CHECK(d.size() == 11 && tail.empty());
+}
+
+//Цепочка связана в обе стороны: обход назад по previous дает то же, что и вперед, а длина совпадает с size().
+template <class D>
+bool linked(const D& d){
+    std::deque<int> forward = contents(d);
+    std::deque<int> backward;
+    for(Node<int>* cur = d.last; cur != nullptr; cur = cur->previous) backward.push_front(cur->value);
+    bool ends = d.empty() ? d.first == nullptr && d.last == nullptr : d.first->previous == nullptr && d.last->next == nullptr;
+    return ends && forward == backward && forward.size() == d.size();
+}
+
+//splice, append и split_at только перевешивают узлы: адреса элементов не меняются, обе цепочки остаются целыми.
+void test_deque_splice(){
+    Deque<int> a;
+    for(int i = 0; i < 10; i++) a.push_back(i);
+    const int* five = &a.at(5);
+    Deque<int> b = a.split_at(5);
+    CHECK(contents(a) == std::deque<int>({0, 1, 2, 3, 4}) && contents(b) == std::deque<int>({5, 6, 7, 8, 9}));
+    CHECK(&b.front() == five && linked(a) && linked(b));
+    //Разрез у самых концов: split_at(0) забирает все, split_at(size()) и дальше - ничего.
+    Deque<int> all = b.split_at(0);
+    CHECK(b.empty() && linked(b) && all.size() == 5 && &all.front() == five);
+    CHECK(all.split_at(5).empty() && all.split_at(100).empty() && all.size() == 5);
+    Deque<int> last = all.split_at(4);
+    CHECK(last.size() == 1 && last.front() == 9 && linked(last) && linked(all) && all.back() == 8);
+
+    //splice в середину, из пустого дека и в пустой дек.
+    Deque<int> empty;
+    a.splice(a.begin(), empty);
+    CHECK(a.size() == 5 && linked(a));
+    empty.splice(empty.end(), last);
+    CHECK(contents(empty) == std::deque<int>({9}) && last.empty() && linked(last) && linked(empty));
+    a.splice(++++a.begin(), all);
+    CHECK(contents(a) == std::deque<int>({0, 1, 5, 6, 7, 8, 2, 3, 4}) && all.empty() && linked(a));
+    a.append(std::move(empty));
+    CHECK(a.size() == 10 && a.back() == 9 && empty.empty() && &a.at(2) == five);
+
+    //Диапазон внутри одного дека: перенос в начало и в конец.
+    a.splice(a.begin(), a, ++++++++++++a.begin(), a.end());
+    CHECK(contents(a) == std::deque<int>({2, 3, 4, 9, 0, 1, 5, 6, 7, 8}) && linked(a));
+    a.splice(a.end(), a, a.begin(), ++++++++a.begin());
+    CHECK(contents(a) == std::deque<int>({0, 1, 5, 6, 7, 8, 2, 3, 4, 9}) && linked(a));
+
+    //Случайная последовательность разрезов и склеек против std::deque.
+    std::vector<Deque<int>> shards(4);
+    std::vector<std::deque<int>> ref(4);
+    for(int i = 0; i < 400; i++){
+        shards[i % 4].push_back(i);
+        ref[i % 4].push_back(i);
+    }
+    std::uint32_t state = 12345;
+    auto next = [&state](std::uint32_t bound){
+        state = state * 1103515245u + 12345u;
+        return (state >> 16) % bound;
+    };
+    bool same = true;
+    for(int step = 0; step < 2000; step++){
+        std::size_t from = next(4), to = next(4);
+        if(from == to) continue;
+        std::size_t index = next(static_cast<std::uint32_t>(ref[from].size() + 1));
+        Deque<int> tail = shards[from].split_at(index);
+        std::deque<int> ref_tail(ref[from].begin() + std::min(index, ref[from].size()), ref[from].end());
+        ref[from].erase(ref[from].begin() + std::min(index, ref[from].size()), ref[from].end());
+        std::size_t at = next(static_cast<std::uint32_t>(ref[to].size() + 1));
+        Deque<int>::iterator pos = shards[to].begin();
+        for(std::size_t i = 0; i < at; i++) ++pos;
+        shards[to].splice(pos, tail);
+        ref[to].insert(ref[to].begin() + at, ref_tail.begin(), ref_tail.end());
+        same = same && tail.empty();
+    }
+    for(std::size_t i = 0; i < 4; i++) same = same && linked(shards[i]) && contents(shards[i]) == ref[i];
+    CHECK(same);
+}
+
+void test_deque_end_iterators(){
+    Deque<int> d;
+    for(int i = 0; i < 3; i++) d.push_back(i);
+    Deque<int>::iterator end = d.end();
+    --end;
+    CHECK(*end == 2);
+    std::deque<int> reversed;
+    for(Deque<int>::reverse_iterator it = d.rbegin(); it != d.rend(); ++it) reversed.push_back(*it);
+    CHECK(reversed == std::deque<int>({2, 1, 0}));
+
+    //splice в end() дописывает в конец, диапазон до other.end() включает последний элемент.
+    Deque<int> other;
+    for(int i = 10; i < 13; i++) other.push_back(i);
+    d.splice(d.end(), other, ++other.begin(), other.end());
+    CHECK(contents(d) == std::deque<int>({0, 1, 2, 11, 12}));
+    CHECK(contents(other) == std::deque<int>({10}));
+    d.splice(d.begin(), other);
+    CHECK(contents(d) == std::deque<int>({10, 0, 1, 2, 11, 12}) && other.empty());
+    d.splice(d.end(), d, d.begin(), ++d.begin());
+    CHECK(contents(d) == std::deque<int>({0, 1, 2, 11, 12, 10}) && d.back() == 10);
+
+    Deque<int>::iterator it = d.end();
+    --it;
+    CHECK(d.erase(it) == d.end() && d.back() == 12);
+    CHECK(d.erase(++d.begin(), d.end()) == d.end());
+    CHECK(contents(d) == std::deque<int>({0}) && d.size() == 1);
+    Deque<int>::iterator inserted = d.insert(d.end(), {5, 6});
+    CHECK(*inserted == 5 && contents(d) == std::deque<int>({0, 5, 6}));
+}
+
+void test_deque_make_contiguous(){
+    Deque<int> d;
+    for(int i = 0; i < 5; i++) d.push_back(i);
+    int out[5] = {};
+    CHECK(d.make_contiguous(out) == out + 5);
+    CHECK(out[0] == 0 && out[4] == 4);
+    Deque<int> none;
+    CHECK(none.make_contiguous(out) == out);
+
+    //rotate(k) для всех k от 0 до 2n против std::rotate: и с ближнего к началу, и с ближнего к концу края, и по модулю.
+    const int n = 7;
+    bool same = true;
+    for(int k = 0; k <= 2 * n; k++){
+        Deque<int> r;
+        std::deque<int> ref;
+        for(int i = 0; i < n; i++){
+            r.push_back(i);
+            ref.push_back(i);
+        }
+        const int* zero = &r.front();
+        r.rotate(k);
+        std::rotate(ref.begin(), ref.begin() + k % n, ref.end());
+        same = same && contents(r) == ref && linked(r) && &r.at((n - k % n) % n) == zero;
+    }
+    CHECK(same);
+    Deque<int> single;
+    single.rotate(3);
+    none.rotate(3);
+    single.push_back(1);
+    single.rotate(5);
+    CHECK(none.empty() && single.size() == 1 && single.front() == 1 && linked(single));
+    Deque<bool> flags;
+    flags.push_back(true);
+    flags.push_back(false);
+    bool bits[2] = {};
+    CHECK(flags.linearize(bits) == bits + 2 && bits[0] && !bits[1]);
+}
+
+//compact() и compact(max_nodes) меняют только расположение узлов: порядок и значения те же, после полного
+//прохода соседние элементы лежат рядом в памяти.
+void test_deque_compact(){
+    Deque<int> d;
+    std::deque<int> ref;
+    for(int i = 0; i < 300; i++){
+        d.push_front(-i);
+        d.push_back(i);
+        ref.push_front(-i);
+        ref.push_back(i);
+    }
+    CHECK(d.fragmentation() > 0.9);
+    d.compact();
+    CHECK(d.fragmentation() == 0 && contents(d) == ref && linked(d));
+    d.compact();
+    CHECK(d.fragmentation() == 0 && d.size() == 600);
+
+    //Пошаговый проход вперемешку с изменениями на обоих концах и в середине.
+    Deque<int> step;
+    ref.clear();
+    for(int i = 0; i < 300; i++){
+        step.push_front(i);
+        ref.push_front(i);
+        step.push_back(i);
+        ref.push_back(i);
+    }
+    bool same = true;
+    int calls = 0;
+    for(bool done = false; !done; calls++){
+        done = step.compact(16);
+        step.push_back(calls);
+        ref.push_back(calls);
+        step.pop_front();
+        ref.pop_front();
+        if(calls % 5 == 0){
+            step.erase(++step.begin());
+            ref.erase(++ref.begin());
+        }
+        same = same && linked(step);
+    }
+    CHECK(same && contents(step) == ref);
+    //Проход видит новые узлы в конце, поэтому занимает больше 600 / 16 вызовов, но заканчивается.
+    CHECK(calls > 600 / 16 && step.fragmentation() < 0.1);
+}
+
+//Узлы из блоков compact() переходят между деками через splice и split_at и освобождаются тем деком, где оказались.
+void test_deque_compacted_nodes_move_between_deques(){
+    Deque<int> a;
+    for(int i = 0; i < 100; i++){
+        a.push_back(i);
+        a.push_front(-i);
+    }
+    a.compact();
+    CHECK(a.fragmentation() == 0);
+    Deque<int> b = a.split_at(50);
+    {
+        Deque<int> c;
+        c.push_back(1000);
+        c.splice(c.end(), a, a.begin(), ++(++a.begin()));
+        CHECK(c.size() == 3 && a.size() == 48);
+    }
+    a.splice(a.end(), b);
+    for(int i = 0; i < 100; i++) a.pop_front();
+    for(int i = 0; i < 10; i++) a.push_back(i);
+    CHECK(a.size() == 108 && b.empty());
+    Deque<int> moved(std::move(a));
+    CHECK(moved.size() == 108 && moved.back() == 9);
+    moved.clear();
+    moved.push_back(1);
+    moved.compact(8);
+    CHECK(moved.size() == 1);
+
+    //Проход compact(max_nodes), прерванный splice всего дека, не продолжается по узлам, ушедшим в другой дек.
+    Deque<int> source;
+    for(int i = 0; i < 500; i++){
+        source.push_front(-i);
+        source.push_back(i + 500);
+    }
+    source.compact(10);
+    Deque<int> target;
+    target.splice(target.end(), source);
+    source.push_back(7);
+    source.compact(100000);
+    CHECK(source.size() == 1 && source.front() == 7 && source.back() == 7);
+    CHECK(target.size() == 1000 && target.front() == -499 && target.back() == 999);
+    target.compact(100000);
+    CHECK(target.fragmentation() < 0.1 && target.size() == 1000);
+
+    //То же при автоматическом compact.
+    Deque<int> automatic;
+    automatic.set_compaction_threshold(0.5, 4);
+    for(int i = 0; i < 200; i++){
+        automatic.push_front(i);
+        automatic.push_back(i);
+    }
+    Deque<int> receiver;
+    receiver.splice(receiver.begin(), automatic);
+    for(int i = 0; i < 300; i++){
+        automatic.push_back(i);
+        automatic.pop_front();
+        automatic.push_back(i);
+    }
+    CHECK(automatic.size() == 300 && receiver.size() == 400);
+}
+
+//Нестандартная политика: маленькие блоки compact, рост в 5/4, проверка индекса и счетчики.
+void test_deque_policy(){
+    using Policy = Deque_policy<4, std::ratio<5, 4>, true, true>;
+    Deque<int, Allocator<Node<int>>, Policy> d;
+    Deque<int> filler;
+    for(int i = 0; i < 100; i++){
+        d.push_back(i);
+        filler.push_back(i);
+    }
+    while(!d.compact(7)){}
+    const Deque_statistics& stats = d.statistics();
+    CHECK(d.fragmentation() < 0.2 && d.front() == 0 && d.back() == 99);
+    //Блоки 4, 5, 6, 7, 8, 10, 12, 15, 18, 22: каждый больше предыдущего хотя бы на узел.
+    CHECK(stats.chunk_allocations == 10 && stats.nodes_relocated == 100);
+    CHECK(stats.node_allocations == 100 && stats.node_deallocations == 0);
+    d.pop_front();
+    CHECK(stats.node_deallocations == 1);
+    bool checked = false;
+    try{
+        d[1000];
+    }
+    catch(const std::out_of_range&){
+        checked = true;
+    }
+    CHECK(checked);
+    CHECK(d[0] == 1 && d[98] == 99);
+
+    //Без проверки индекса operator[] так же проходит pos узлов, а erase_if с политикой удаляет по предикату.
+    Deque<int, Allocator<Node<int>>, Deque_policy<>> plain;
+    for(int i = 0; i < 10; i++) plain.push_back(i);
+    const auto& view = plain;
+    CHECK(plain[0] == 0 && plain[9] == 9 && view[5] == 5);
+    CHECK(erase_if(plain, [](int value){ return value % 3 == 0; }) == 4);
+    CHECK(plain.size() == 6 && plain.front() == 1 && plain.back() == 8 && plain[2] == 4);
+    CHECK(erase_if(d, [](int value){ return value >= 50; }) == 50 && d.size() == 49 && d.back() == 49);
+}
+
+//Снимок больше одного буфера (64 КиБ), пустой снимок, снимок через сериализатор и загрузка поверх непустого дека.
+void test_deque_save_load(){
+    Deque<int> big;
+    for(int i = 0; i < 50000; i++) big.push_back(i * 3);
+    std::stringstream raw;
+    big.save(raw);
+    CHECK(raw.str().size() == 24 + 50000 * sizeof(int));
+    Deque<int> loaded;
+    loaded.push_back(-1);
+    loaded.load(raw);
+    CHECK(contents(loaded) == contents(big) && linked(loaded) && loaded.fragmentation() == 0);
+    //Узлы загруженного блока удаляются и добавляются как обычные.
+    for(int i = 0; i < 49990; i++) loaded.pop_front();
+    loaded.push_front(7);
+    loaded.erase(++loaded.begin());
+    CHECK(loaded.size() == 10 && loaded.front() == 7 && loaded.back() == 149997 && linked(loaded));
+
+    Deque<int> empty;
+    std::stringstream nothing;
+    empty.save(nothing);
+    loaded.load(nothing);
+    CHECK(loaded.empty() && linked(loaded));
+
+    Deque<std::string> words;
+    for(const char* word : {"", "one", "two words", "three"}) words.push_back(word);
+    std::stringstream text;
+    auto write_word = [](std::ostream& out, const std::string& word){
+        std::uint32_t length = static_cast<std::uint32_t>(word.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(word.data(), length);
+    };
+    auto read_word = [](std::istream& in){
+        std::uint32_t length = 0;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::string word(length, '\0');
+        in.read(&word[0], length);
+        return word;
+    };
+    words.save(text, write_word);
+    std::string serialized = text.str();
+    Deque<std::string> read_back;
+    read_back.load(text, read_word);
+    CHECK(read_back.size() == 4 && read_back.front().empty() && read_back.at(2) == "two words" && read_back.back() == "three");
+
+    //Снимок с сериализатором не читается как сырой, и наоборот; другой размер элемента тоже отвергается.
+    auto rejects = [](auto load){
+        try{
+            load();
+        }
+        catch(const std::runtime_error&){
+            return true;
+        }
+        return false;
+    };
+    std::stringstream raw_again;
+    big.save(raw_again);
+    std::string raw_bytes = raw_again.str();
+    CHECK(rejects([&]{
+        std::stringstream in(raw_bytes);
+        read_back.load(in, read_word);
+    }));
+    CHECK(read_back.size() == 4);
+    CHECK(rejects([&]{
+        std::stringstream in(raw_bytes);
+        Deque<long long> wider;
+        wider.load(in);
+    }));
+    CHECK(rejects([&]{
+        std::string bytes = raw_bytes;
+        bytes[4] = 2;
+        std::stringstream in(bytes);
+        loaded.load(in);
+    }));
+    CHECK(rejects([&]{
+        std::stringstream in(serialized);
+        Deque<std::uint32_t> words_as_raw;
+        words_as_raw.load(in);
+    }));
+}
+
+void test_deque_load_rejects_bad_header(){
+    Deque<int> d;
+    for(int i = 0; i < 3; i++) d.push_back(i);
+    std::stringstream good;
+    d.save(good);
+    Deque<int> loaded;
+    loaded.load(good);
+    CHECK(contents(loaded) == std::deque<int>({0, 1, 2}));
+
+    //Заголовок - 16 байт (magic, версия, флаги, размер элемента), за ним 8 байт числа элементов.
+    for(std::uint64_t count : {std::uint64_t(1000), std::uint64_t(1) << 62, ~std::uint64_t(0)}){
+        std::string bytes = good.str();
+        std::memcpy(&bytes[16], &count, sizeof(count));
+        std::stringstream bad(bytes);
+        bool threw = false;
+        try{
+            loaded.load(bad);
+        }
+        catch(const std::runtime_error&){
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(loaded.size() == 3);
+    }
+
+    std::string cut = good.str();
+    cut.resize(cut.size() - 2);
+    std::stringstream truncated(cut);
+    bool threw = false;
+    try{
+        loaded.load(truncated);
+    }
+    catch(const std::runtime_error&){
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+template <class D>
+std::deque<int> cow_contents(const D& d){
+    std::deque<int> out;
+    for(int value : d) out.push_back(value);
+    return out;
+}
+
+void test_cow_deque(){
+    CowDeque<int> a(4);
+    for(int i = 0; i < 20; i++) a.push_back(i);
+    CHECK(a.segment_count() == 5 && a.shared_segments() == 0);
+    CowDeque<int> b = a.snapshot();
+    CHECK(a.shared_segments() == 5 && b.shared_segments() == 5);
+    //Чтение через const не разделяет, запись дублирует ровно один сегмент.
+    const CowDeque<int>& view = b;
+    CHECK(view[10] == 10 && b.shared_segments() == 5);
+    b[10] = 100;
+    CHECK(a.shared_segments() == 4 && b.shared_segments() == 4 && a[10] == 10 && b[10] == 100);
+    //Первый сегмент полный, push_front заводит новый и не трогает общие.
+    b.push_front(-1);
+    CHECK(b.segment_count() == 6 && b.shared_segments() == 4 && a.front() == 0 && b.front() == -1);
+    CHECK(a.size() == 20 && b.size() == 21 && a[4] == 4 && b[5] == 4);
+
+    //Много снимков подряд: каждый остается таким, каким был в момент snapshot().
+    CowDeque<int> live(3);
+    std::deque<int> ref;
+    std::vector<CowDeque<int>> snapshots;
+    std::vector<std::deque<int>> expected;
+    std::uint32_t state = 7;
+    for(int step = 0; step < 3000; step++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 6;
+        if(op == 0 || ref.empty()){
+            live.push_back(step);
+            ref.push_back(step);
+        }
+        else if(op == 1){
+            live.push_front(step);
+            ref.push_front(step);
+        }
+        else if(op == 2){
+            live.pop_back();
+            ref.pop_back();
+        }
+        else if(op == 3){
+            live.pop_front();
+            ref.pop_front();
+        }
+        else{
+            std::size_t pos = (state >> 8) % ref.size();
+            live[pos] = -step;
+            ref[pos] = -step;
+        }
+        if(step % 100 == 0){
+            snapshots.push_back(live.snapshot());
+            expected.push_back(ref);
+        }
+    }
+    bool same = cow_contents(live) == ref && live.size() == ref.size();
+    for(std::size_t i = 0; i < snapshots.size(); i++) same = same && cow_contents(snapshots[i]) == expected[i];
+    CHECK(same);
+    live.clear();
+    CHECK(live.empty() && cow_contents(snapshots.back()) == expected.back());
+}
+
+void test_persistent_deque(){
+    PersistentDeque<int> empty;
+    PersistentDeque<int> p = empty;
+    for(int i = 0; i < 100; i++) p = p.push_back(i);
+    PersistentDeque<int> q = p.pop_front().set(10, -5);
+    CHECK(p.size() == 100 && q.size() == 99);
+    CHECK(p[10] == 10 && q[10] == -5 && q.front() == 1 && q.back() == 99);
+
+    //Внутренние узлы не хранят T, так что T без конструктора по умолчанию тоже подходит.
+    struct Boxed {
+        explicit Boxed(int value) : value(value) {}
+        int value;
+    };
+    PersistentDeque<Boxed> b;
+    for(int i = 0; i < 50; i++) b = b.push_front(Boxed(i));
+    b = b.set(25, Boxed(-1));
+    CHECK(b.size() == 50 && b.front().value == 49 && b.back().value == 0 && b[25].value == -1);
+
+    //История из 2000 версий: каждая версия после любых последующих операций та же, что при создании.
+    std::vector<PersistentDeque<int>> versions(1);
+    std::vector<std::deque<int>> refs(1);
+    std::uint32_t state = 99;
+    for(int step = 0; step < 2000; step++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 5;
+        const PersistentDeque<int>& prev = versions.back();
+        std::deque<int> ref = refs.back();
+        if(op == 0 || (ref.empty() && op > 1)){
+            versions.push_back(prev.push_back(step));
+            ref.push_back(step);
+        }
+        else if(op == 1){
+            versions.push_back(prev.push_front(step));
+            ref.push_front(step);
+        }
+        else if(op == 2){
+            versions.push_back(prev.pop_back());
+            ref.pop_back();
+        }
+        else if(op == 3){
+            versions.push_back(prev.pop_front());
+            ref.pop_front();
+        }
+        else{
+            std::size_t pos = (state >> 8) % ref.size();
+            versions.push_back(prev.set(pos, -step));
+            ref[pos] = -step;
+        }
+        refs.push_back(ref);
+    }
+    bool same = true;
+    for(std::size_t v = 0; v < versions.size(); v += 7){
+        std::deque<int> walked;
+        versions[v].for_each([&walked](int value){ walked.push_back(value); });
+        same = same && walked == refs[v] && versions[v].size() == refs[v].size();
+        for(std::size_t i = 0; i < refs[v].size(); i += 5) same = same && versions[v][i] == refs[v][i];
+    }
+    CHECK(same);
+
+    //Опустошение глубокого дерева с каждого конца.
+    PersistentDeque<int> deep;
+    for(int i = 0; i < 1000; i++) deep = deep.push_back(i);
+    PersistentDeque<int> left = deep, right = deep;
+    bool drained = true;
+    for(int i = 0; i < 1000; i++){
+        drained = drained && left.front() == i && right.back() == 999 - i && left.at(left.size() - 1) == 999;
+        left = left.pop_front();
+        right = right.pop_back();
+    }
+    CHECK(drained && left.empty() && right.empty() && deep.size() == 1000 && deep[500] == 500);
+    bool thrown = false;
+    try{
+        deep.at(1000);
+    }
+    catch(const std::out_of_range&){
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void test_mapped_deque(){
+    std::string path = scratch_dir() + "/mapped";
+    {
+        MappedDeque<int> m(path, 4);
+        for(int i = 0; i < 10; i++) m.push_back(i);
+        m.push_front(-1);
+        m.sync();
+    }
+    MappedDeque<int> m(path);
+    CHECK(m.size() == 11 && m.front() == -1 && m.back() == 9);
+
+    //Кольцо, перешедшее через конец файла, растет и переоткрывается с тем же порядком элементов.
+    std::string ring_path = scratch_dir() + "/mapped_ring";
+    std::deque<int> ref;
+    {
+        MappedDeque<int> ring(ring_path, 8);
+        for(int i = 0; i < 6; i++){
+            ring.push_back(i);
+            ref.push_back(i);
+        }
+        for(int i = 0; i < 4; i++){
+            ring.pop_front();
+            ref.pop_front();
+        }
+        for(int i = 0; i < 3; i++){
+            ring.push_front(-i);
+            ref.push_front(-i);
+        }
+        for(int i = 6; i < 9; i++){
+            ring.push_back(i);
+            ref.push_back(i);
+        }
+        CHECK(ring.capacity() == 8 && ring.size() == 8);
+        ring.push_back(9);
+        ref.push_back(9);
+        ring.push_front(-9);
+        ref.push_front(-9);
+        CHECK(ring.capacity() == 16);
+        ring.sync();
+    }
+    MappedDeque<int> reopened(ring_path);
+    bool same = reopened.size() == ref.size() && reopened.capacity() == 16;
+    for(std::size_t i = 0; same && i < ref.size(); i++) same = reopened[i] == ref[i];
+    CHECK(same);
+    for(int i = 0; i < 100; i++) reopened.push_front(i);
+    CHECK(reopened.size() == 110 && reopened.front() == 99 && reopened.back() == 9 && reopened.at(100) == -9);
+
+    //Файл с другим размером элемента и не файл дека не открываются.
+    bool wrong_size = false;
+    try{
+        MappedDeque<long long> wider(ring_path);
+    }
+    catch(const std::runtime_error&){
+        wrong_size = true;
+    }
+    std::string other_path = scratch_dir() + "/mapped_other";
+    std::ofstream(other_path) << "not a deque file, just some text long enough for the header";
+    bool not_deque = false;
+    try{
+        MappedDeque<int> other(other_path);
+    }
+    catch(const std::runtime_error&){
+        not_deque = true;
+    }
+    CHECK(wrong_size && not_deque);
+}
+
+void test_spill_deque(){
+    SpillDeque<int> s(scratch_dir() + "/spill", 4 * 16 * sizeof(int), 16, 1);
+    std::deque<int> ref;
+    for(int i = 0; i < 1000; i++){
+        s.push_back(i);
+        ref.push_back(i);
+    }
+    CHECK(s.spilled_blocks() > 0);
+    bool same = true;
+    while(!ref.empty()){
+        same = same && s.front() == ref.front();
+        s.pop_front();
+        ref.pop_front();
+    }
+    CHECK(same && s.empty());
+
+    //Блоки, которые читаются заранее, тоже укладываются в бюджет в 4 блока: 2 у каждого конца.
+    SpillDeque<int> b(scratch_dir() + "/spill_budget", 4 * 16 * sizeof(int), 16, 1);
+    for(int i = 0; i < 1000; i++) b.push_back(i);
+    bool within_budget = true;
+    for(int i = 0; !b.empty(); i++){
+        if(i % 3 == 0) b.pop_back();
+        else b.pop_front();
+        within_budget = within_budget && b.resident_blocks() <= 4;
+    }
+    CHECK(within_budget);
+
+    //push_front тоже вытесняет середину, а pop_back читает блоки с конца в обратном порядке.
+    SpillDeque<int> both(scratch_dir() + "/spill_both", 6 * 8 * sizeof(int), 8, 2);
+    std::deque<int> both_ref;
+    for(int i = 0; i < 400; i++){
+        both.push_front(i);
+        both_ref.push_front(i);
+    }
+    CHECK(both.spilled_blocks() == 50 - 6 && both.resident_blocks() == 6);
+    std::uint32_t state = 3;
+    bool mixed = true;
+    for(int step = 0; step < 3000 && mixed; step++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 4;
+        if(op == 0){
+            both.push_back(step);
+            both_ref.push_back(step);
+        }
+        else if(op == 1){
+            both.push_front(step);
+            both_ref.push_front(step);
+        }
+        else if(!both_ref.empty() && op == 2){
+            mixed = both.back() == both_ref.back();
+            both.pop_back();
+            both_ref.pop_back();
+        }
+        else if(!both_ref.empty()){
+            mixed = both.front() == both_ref.front();
+            both.pop_front();
+            both_ref.pop_front();
+        }
+        mixed = mixed && both.size() == both_ref.size() && both.resident_blocks() <= 6;
+    }
+    while(mixed && !both_ref.empty()){
+        mixed = both.back() == both_ref.back();
+        both.pop_back();
+        both_ref.pop_back();
+    }
+    CHECK(mixed && both.empty());
+
+    //Деструктор при запросах, которые поток чтения еще не выполнил.
+    {
+        SpillDeque<int> pending(scratch_dir() + "/spill_pending", 8 * 16 * sizeof(int), 16, 3);
+        for(int i = 0; i < 1000; i++) pending.push_back(i);
+        for(int i = 0; i < 200; i++) pending.pop_front();
+        CHECK(pending.front() == 200 && pending.back() == 999);
+    }
+}
+
+std::string read_file(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& data){
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void test_journaled_deque(){
+    std::string path = scratch_dir() + "/journal";
+    {
+        JournaledDeque<int> j(path);
+        for(int i = 0; i < 10; i++) j.push_back(i);
+        j.pop_front();
+        j.sync();
+    }
+    JournaledDeque<int> j(path);
+    CHECK(j.size() == 9 && j.front() == 1 && j.back() == 9);
+}
+
+//Снимает все элементы спереди: у JournaledDeque нет обхода, а переоткрытый дек после проверки не нужен.
+std::deque<int> drain(JournaledDeque<int>& j){
+    std::deque<int> out;
+    while(!j.empty()){
+        out.push_back(j.front());
+        j.pop_front();
+    }
+    return out;
+}
+
+//Несколько писателей делят fdatasync, журнал несколько раз заменяется снимком, недописанная запись отбрасывается.
+void test_journaled_deque_recovery(){
+    std::string path = scratch_dir() + "/journal_group";
+    {
+        JournaledDeque<int> j(path, std::chrono::microseconds(200));
+        std::vector<std::thread> writers;
+        for(int w = 0; w < 4; w++){
+            writers.emplace_back([&j, w]{
+                for(int i = 0; i < 250; i++) j.push_back(w * 1000 + i);
+            });
+        }
+        for(std::thread& t : writers) t.join();
+    }
+    JournaledDeque<int> group(path);
+    std::deque<int> values = drain(group);
+    //Элементы каждого писателя идут в своем порядке.
+    std::vector<int> next(4, 0);
+    bool ordered = values.size() == 1000;
+    for(int value : values){
+        ordered = ordered && value % 1000 == next[value / 1000];
+        next[value / 1000]++;
+    }
+    CHECK(ordered);
+
+    //Порог снимка в 64 байта: журнал заменяется снимком много раз по ходу работы.
+    std::string snap_path = scratch_dir() + "/journal_snap";
+    std::deque<int> ref;
+    {
+        JournaledDeque<int> j(snap_path, std::chrono::microseconds(100), true, 64);
+        for(int i = 0; i < 300; i++){
+            if(i % 3 == 0){
+                j.push_front(i);
+                ref.push_front(i);
+            }
+            else{
+                j.push_back(i);
+                ref.push_back(i);
+            }
+            if(i % 7 == 0){
+                j.pop_back();
+                ref.pop_back();
+            }
+        }
+        CHECK(read_file(snap_path + ".log").size() < 64 + 8 + 5 && !read_file(snap_path + ".snap").empty());
+    }
+    {
+        JournaledDeque<int> j(snap_path);
+        CHECK(j.size() == ref.size() && j.front() == ref.front() && j.back() == ref.back());
+        j.push_back(1000);
+        j.sync();
+    }
+    //Оборванная запись push_back в конце журнала: тип записи и половина значения.
+    std::string log = read_file(snap_path + ".log");
+    write_file(snap_path + ".log", log + std::string(1, '\1') + std::string(2, '\7'));
+    ref.push_back(1000);
+    {
+        JournaledDeque<int> j(snap_path);
+        CHECK(j.size() == ref.size() && j.back() == 1000);
+        j.push_back(1001);
+        j.sync();
+    }
+    ref.push_back(1001);
+    JournaledDeque<int> torn(snap_path);
+    CHECK(drain(torn) == ref);
+}
+
+//Сбой между rename снимка и обнулением журнала: рядом с новым снимком остается старый журнал.
+void test_journaled_deque_crash_after_snapshot(){
+    std::string path = scratch_dir() + "/journal_crash";
+    {
+        JournaledDeque<int> j(path);
+        for(int i = 0; i < 5; i++) j.push_back(i);
+        j.sync();
+        std::string stale_log = read_file(path + ".log");
+        j.checkpoint();
+        j.push_back(5);
+        j.sync();
+        write_file(path + ".log", stale_log);
+    }
+    JournaledDeque<int> j(path);
+    CHECK(j.size() == 5 && j.front() == 0 && j.back() == 4);
+
+    //Журнал, который снимает элемент с пустого дека, отвергается.
+    std::string bad = scratch_dir() + "/journal_bad";
+    write_file(bad + ".log", std::string(8, '\0') + std::string(1, '\4'));
+    bool rejected = false;
+    try{
+        JournaledDeque<int> broken(bad);
+    }
+    catch(const std::runtime_error&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+void test_byte_deque(){
+    ByteDeque b(8, 1);
+    std::string text = "the quick brown fox jumps over the lazy dog";
+    b.append(text.data(), text.size());
+    CHECK(b.size() == text.size());
+    int fds[2];
+    CHECK(::pipe(fds) == 0);
+    CHECK(b.write_to(fds[1]) == text.size());
+    ByteDeque in(8, 1);
+    CHECK(in.read_from(fds[0], text.size()) == text.size());
+    struct iovec iov[16];
+    std::string back;
+    std::size_t n = in.peek_iovecs(iov, 16);
+    for(std::size_t i = 0; i < n; i++) back.append(static_cast<char*>(iov[i].iov_base), iov[i].iov_len);
+    CHECK(back == text);
+
+    //Пустое чтение без свободного блока в конце не вызывает readv.
+    ByteDeque none(8, 1);
+    CHECK(none.read_from(fds[0], 0) == 0 && none.empty());
+
+    //Очередь через кольцо каталога: данные выходят в том же порядке, пока кольцо многократно оборачивается.
+    ByteDeque ring(4, 2);
+    std::string written;
+    std::string read;
+    for(int round = 0; round < 200; round++){
+        std::string piece = std::to_string(round * 7919);
+        ring.append(piece.data(), piece.size());
+        written += piece;
+        std::size_t pieces = ring.peek_iovecs(iov, 1);
+        if(pieces == 1 && round % 3 != 0){
+            read.append(static_cast<char*>(iov[0].iov_base), iov[0].iov_len);
+            ring.consume(iov[0].iov_len);
+        }
+    }
+    while(!ring.empty()){
+        ring.peek_iovecs(iov, 1);
+        read.append(static_cast<char*>(iov[0].iov_base), iov[0].iov_len);
+        ring.consume(iov[0].iov_len);
+    }
+    CHECK(read == written);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    //prepare_iovecs через границу блоков, частичный commit, consume больше, чем есть.
+    ByteDeque parts(8, 1);
+    parts.append("abc", 3);
+    std::size_t spaces = parts.prepare_iovecs(iov, 16, 20);
+    std::size_t room = 0;
+    for(std::size_t i = 0; i < spaces; i++) room += iov[i].iov_len;
+    CHECK(spaces == 3 && room == 5 + 8 + 8 && iov[0].iov_len == 5);
+    std::memcpy(iov[0].iov_base, "defgh", 5);
+    std::memcpy(iov[1].iov_base, "ij", 2);
+    parts.commit(7);
+    CHECK(parts.size() == 10 && parts.peek_iovecs(iov, 16) == 2 && iov[0].iov_len == 8 && iov[1].iov_len == 2);
+    CHECK(parts.peek_iovecs(iov, 1) == 1 && std::string(static_cast<char*>(iov[0].iov_base), 8) == "abcdefgh");
+    parts.consume(9);
+    CHECK(parts.size() == 1 && parts.peek_iovecs(iov, 16) == 1 && *static_cast<char*>(iov[0].iov_base) == 'j');
+    parts.consume(100);
+    CHECK(parts.empty() && parts.peek_iovecs(iov, 16) == 0);
+
+    //Неблокирующий канал: writev пишет частично, пока канал полон, возвращается 0, конец файла - тоже 0.
+    CHECK(::pipe(fds) == 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    ByteDeque out(4096, 2);
+    ByteDeque received(4096, 2);
+    std::string payload;
+    for(int i = 0; payload.size() < 1000000; i++) payload += std::to_string(i) + ",";
+    out.append(payload.data(), payload.size());
+    bool stalled = false;
+    std::string got;
+    while(!out.empty()){
+        while(!out.empty() && out.write_to(fds[1]) > 0){}
+        stalled = stalled || !out.empty();
+        while(received.read_from(fds[0], 65536) > 0){}
+        while(!received.empty()){
+            received.peek_iovecs(iov, 1);
+            got.append(static_cast<char*>(iov[0].iov_base), iov[0].iov_len);
+            received.consume(iov[0].iov_len);
+        }
+    }
+    ::close(fds[1]);
+    CHECK(received.read_from(fds[0], 100) == 0 && received.empty());
+    ::close(fds[0]);
+    CHECK(got == payload && stalled);
+}
+
+void test_shared_deque(){
+    std::string name = "/labtwo_tests_" + std::to_string(::getpid());
+    {
+        SharedDeque<int> producer(name, 8);
+        SharedDeque<int> consumer(name);
+        for(int i = 0; i < 5; i++) CHECK(producer.try_push_back(i));
+        int value = -1;
+        CHECK(consumer.try_pop_front(value) && value == 0);
+        CHECK(consumer.size() == 4);
+
+        //Второй создатель не может заново инициализировать сегмент, которым уже пользуются.
+        bool refused = false;
+        try{
+            SharedDeque<int> again(name, 8);
+        }
+        catch(const std::system_error& e){
+            refused = e.code().value() == EEXIST;
+        }
+        CHECK(refused && consumer.size() == 4);
+    }
+    SharedDeque<int>::unlink(name);
+    SharedDeque<int> fresh(name, 8);
+    CHECK(fresh.empty());
+    SharedDeque<int>::unlink(name);
+
+    //Емкость округляется до степени двойки, полное кольцо отказывает в try_push_back, индексы оборачиваются.
+    std::string ring_name = name + "_ring";
+    SharedDeque<int> ring(ring_name, 5);
+    CHECK(ring.capacity() == 8);
+    bool wrapped = true;
+    int value = -1;
+    for(int round = 0; round < 100; round++){
+        for(int i = 0; i < 8; i++) wrapped = wrapped && ring.try_push_back(round * 8 + i);
+        wrapped = wrapped && !ring.try_push_back(-1) && ring.size() == 8;
+        for(int i = 0; i < 8; i++) wrapped = wrapped && ring.try_pop_front(value) && value == round * 8 + i;
+        wrapped = wrapped && !ring.try_pop_front(value) && ring.empty();
+    }
+    CHECK(wrapped);
+    bool mismatch = false;
+    try{
+        SharedDeque<long long> wider(ring_name);
+    }
+    catch(const std::runtime_error&){
+        mismatch = true;
+    }
+    CHECK(mismatch);
+
+    //Потребитель в другом процессе: через кольцо на 8 элементов обе стороны постоянно засыпают на futex.
+    pid_t child = ::fork();
+    if(child == 0){
+        SharedDeque<int> consumer(ring_name);
+        for(int i = 0; i < 100000; i++){
+            if(consumer.pop_front() != i) ::_exit(1);
+        }
+        ::_exit(0);
+    }
+    for(int i = 0; i < 100000; i++) ring.push_back(i);
+    int status = -1;
+    CHECK(child > 0 && ::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(ring.empty());
+    SharedDeque<int>::unlink(ring_name);
+}
+
+void test_compressed_deque(){
+    CompressedDeque<int> c(16, 1);
+    for(int i = 0; i < 1000; i++) c.push_back(i * 3);
+    CHECK(c.compressed_blocks() > 0);
+    CHECK(c[500] == 1500 && c.at(999) == 2997);
+    c.pop_front();
+    CHECK(c.front() == 3);
+
+    //Монотонные метки времени: сжатые блоки занимают несколько бит на элемент.
+    CompressedDeque<std::int64_t> stamps(256, 1);
+    std::int64_t stamp = 1700000000000;
+    for(int i = 0; i < 100000; i++) stamps.push_back(stamp += 1 + i % 5);
+    CHECK(stamps.memory_usage() * 8 < 100000 * sizeof(std::int64_t) && stamps.back() == stamp);
+
+    //Крайние значения: разность соседних элементов не помещается в int64_t, знак меняется каждый шаг.
+    CompressedDeque<std::int64_t> wide(8, 1);
+    std::deque<std::int64_t> ref;
+    const std::int64_t extremes[] = {INT64_MIN, INT64_MAX, 0, -1, 1, INT64_MIN + 1, INT64_MAX - 1};
+    std::uint64_t state = 88172645463325252ull;
+    for(int i = 0; i < 2000; i++){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::int64_t value = i % 3 == 0 ? extremes[state % 7] : static_cast<std::int64_t>(state);
+        if(i % 4 == 0){
+            wide.push_front(value);
+            ref.push_front(value);
+        }
+        else{
+            wide.push_back(value);
+            ref.push_back(value);
+        }
+    }
+    CHECK(wide.compressed_blocks() > 100);
+    bool same = true;
+    std::size_t at = 0;
+    wide.for_each([&](std::int64_t value){ same = same && value == ref[at++]; });
+    for(std::size_t i = 0; i < ref.size(); i += 13) same = same && wide[i] == ref[i];
+    //Снятие с обоих концов распаковывает сжатые блоки по мере приближения.
+    while(same && !ref.empty()){
+        same = wide.front() == ref.front() && wide.back() == ref.back();
+        wide.pop_front();
+        ref.pop_front();
+        if(!ref.empty()){
+            wide.pop_back();
+            ref.pop_back();
+        }
+    }
+    CHECK(same && wide.empty() && wide.compressed_blocks() == 0);
+
+    CompressedDeque<std::uint8_t> bytes(4, 1);
+    for(int i = 0; i < 300; i++) bytes.push_back(static_cast<std::uint8_t>(i * 37));
+    CHECK(bytes.compressed_blocks() > 0 && bytes[150] == static_cast<std::uint8_t>(150 * 37) && bytes.at(299) == static_cast<std::uint8_t>(299 * 37));
+}
+
+void test_packed_deque(){
+    PackedDeque<2> p;
+    for(int i = 0; i < 100; i++) p.push_back(static_cast<std::uint8_t>(i % 4));
+    p.push_front(3);
+    CHECK(p.size() == 101 && p.count(3) == 26);
+    BitDeque bits(70, 1);
+    CHECK(bits.count() == 70);
+
+    //Скользящее окно флагов: голова кольца обходит слова, count и any считают по словам с частичными краями.
+    BitDeque window;
+    std::deque<bool> flags;
+    std::uint32_t state = 5;
+    bool same = true;
+    for(int i = 0; i < 5000; i++){
+        state = state * 1103515245u + 12345u;
+        bool flag = (state >> 16) % 3 == 0;
+        window.push_back(flag);
+        flags.push_back(flag);
+        if(flags.size() > 200){
+            window.pop_front();
+            flags.pop_front();
+        }
+        if(i % 37 == 0){
+            std::size_t set = static_cast<std::size_t>(std::count(flags.begin(), flags.end(), true));
+            same = same && window.count() == set && window.count(0) == flags.size() - set && window.any() == (set > 0);
+        }
+    }
+    CHECK(same && window.capacity() == 256);
+    CHECK(window.memory_usage() == 4 * sizeof(std::uint64_t));
+    window.fill(0);
+    CHECK(!window.any() && window.size() == 200);
+    window[199] = 1;
+    CHECK(window.any() && window.count() == 1 && window.back() == 1);
+
+    //Четырехбитные дорожки: рост при обернутом кольце сохраняет порядок, прокси пишет только свою дорожку.
+    PackedDeque<4> nibbles;
+    std::deque<int> ref;
+    for(int i = 0; i < 10; i++){
+        nibbles.push_back(static_cast<std::uint8_t>(i));
+        ref.push_back(i);
+    }
+    for(int i = 0; i < 6; i++){
+        nibbles.pop_front();
+        ref.pop_front();
+    }
+    for(int i = 0; i < 40; i++){
+        nibbles.push_front(static_cast<std::uint8_t>(15 - i % 16));
+        ref.push_front(15 - i % 16);
+    }
+    nibbles[3] = 9;
+    ref[3] = 9;
+    bool lanes = nibbles.size() == ref.size();
+    for(std::size_t i = 0; lanes && i < ref.size(); i++) lanes = nibbles[i] == ref[i];
+    CHECK(lanes && nibbles.count(9) == static_cast<std::size_t>(std::count(ref.begin(), ref.end(), 9)));
+}
+
+void test_soa_deque(){
+    SoaDeque<int, double> s(4);
+    for(int i = 0; i < 10; i++) s.push_back(i, i * 0.5);
+    s.push_front(-1, -0.5);
+    CHECK(s.size() == 11 && s.get<0>(0) == -1 && s.get<1>(10) == 4.5);
+
+    //Очередь в установившемся режиме: каталог блоков не растет вместе с числом пройденных записей.
+    SoaDeque<int, double> fifo(4);
+    bool in_order = true;
+    for(int i = 0; i < 100000; i++){
+        fifo.push_back(i, i * 0.5);
+        if(fifo.size() > 10){
+            in_order = in_order && fifo.get<0>(0) == i - 10;
+            fifo.pop_front();
+        }
+    }
+    CHECK(in_order && fifo.size() == 10 && fifo.directory_slots() <= 8);
+
+    //Записи с обоих концов: столбцы остаются согласованы, for_each_span отдает каждый столбец кусками не длиннее блока.
+    SoaDeque<std::int64_t, int, double> records(8);
+    std::deque<std::tuple<std::int64_t, int, double>> ref;
+    std::uint32_t state = 11;
+    for(int i = 0; i < 3000; i++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 5;
+        if(op <= 1){
+            records.push_back(i * 1000, i, i * 0.25);
+            ref.emplace_back(i * 1000, i, i * 0.25);
+        }
+        else if(op == 2){
+            records.push_front(-i * 1000, -i, -i * 0.25);
+            ref.emplace_front(-i * 1000, -i, -i * 0.25);
+        }
+        else if(op == 3 && !ref.empty()){
+            records.pop_back();
+            ref.pop_back();
+        }
+        else if(!ref.empty()){
+            records.pop_front();
+            ref.pop_front();
+        }
+    }
+    records.get<2>(0) = 100.5;
+    std::get<2>(ref[0]) = 100.5;
+    bool same = records.size() == ref.size() && records.front() == ref.front() && records.back() == ref.back();
+    for(std::size_t i = 0; same && i < ref.size(); i++) same = records[i] == ref[i] && records.get<1>(i) == std::get<1>(ref[i]);
+    long long ids = 0;
+    std::size_t seen = 0;
+    bool short_spans = true;
+    records.for_each_span<1>([&](const int* data, std::size_t n){
+        short_spans = short_spans && n > 0 && n <= 8;
+        for(std::size_t i = 0; i < n; i++) ids += data[i];
+        seen += n;
+    });
+    long long ref_ids = 0;
+    for(const auto& record : ref) ref_ids += std::get<1>(record);
+    CHECK(same && short_spans && seen == ref.size() && ids == ref_ids);
+}
+
+void test_record_deque(){
+    RecordDeque r(64);
+    for(int i = 0; i < 20; i++) r.push_back(std::string(i, 'x'));
+    r.push_front("head");
+    CHECK(r.size() == 21 && r.front() == "head" && r[20].size() == 19);
+
+    //Очередь в установившемся режиме: каталог блоков не растет вместе с числом пройденных записей.
+    RecordDeque fifo(32);
+    bool in_order = true;
+    for(int i = 0; i < 100000; i++){
+        fifo.push_back(std::to_string(i));
+        if(fifo.size() > 10){
+            in_order = in_order && fifo.front() == std::to_string(i - 10);
+            fifo.pop_front();
+        }
+    }
+    CHECK(in_order && fifo.size() == 10 && fifo.directory_slots() <= 2 * fifo.chunk_count() + 4);
+
+    //Пустые записи, записи с нулевыми байтами и записи длиннее блока, с обоих концов, против std::deque.
+    RecordDeque mixed(64);
+    std::deque<std::string> ref;
+    std::uint32_t state = 17;
+    for(int i = 0; i < 4000; i++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 6;
+        std::size_t length = (state >> 8) % 7 == 0 ? 100 + (state >> 4) % 200 : (state >> 4) % 24;
+        std::string record(length, static_cast<char>('a' + i % 26));
+        if(!record.empty()) record[record.size() / 2] = '\0';
+        if(op <= 1){
+            mixed.push_back(record);
+            ref.push_back(record);
+        }
+        else if(op == 2){
+            mixed.push_front(record);
+            ref.push_front(record);
+        }
+        else if(op == 3 && !ref.empty()){
+            mixed.pop_back();
+            ref.pop_back();
+        }
+        else if(!ref.empty()){
+            mixed.pop_front();
+            ref.pop_front();
+        }
+    }
+    bool same = mixed.size() == ref.size() && !ref.empty();
+    for(std::size_t i = 0; same && i < ref.size(); i++) same = mixed[i] == ref[i];
+    std::size_t at = 0;
+    mixed.for_each([&](std::string_view record){ same = same && record == ref[at++]; });
+    CHECK(same && at == ref.size() && mixed.front() == ref.front() && mixed.back() == ref.back());
+    //Блоки освобождаются целиком, когда из них сняты все записи.
+    while(!mixed.empty()) mixed.pop_back();
+    CHECK(mixed.chunk_count() == 0);
+    mixed.push_front(std::string());
+    CHECK(mixed.size() == 1 && mixed.front().empty() && mixed.chunk_count() == 1);
+}
+
+struct Item {
+    int value;
+    IntrusiveHook<Item> hook;
+    IntrusiveHook<Item> second_hook;
+};
+
+template <class D>
+std::deque<int> item_values(const D& d){
+    std::deque<int> out;
+    for(const Item& item : d) out.push_back(item.value);
+    return out;
+}
+
+void test_intrusive_deque(){
+    Item items[6] = {{0, {}, {}}, {1, {}, {}}, {2, {}, {}}, {3, {}, {}}, {4, {}, {}}, {5, {}, {}}};
+    IntrusiveDeque<Item, &Item::hook> d;
+    for(int i = 0; i < 4; i++) d.push_back(items[i]);
+    d.erase(items[1]);
+    CHECK(d.size() == 3 && d.front().value == 0 && d.back().value == 3);
+    //Вырезанный объект снова свободен, его можно вставить в любое место.
+    CHECK(items[1].hook.next == nullptr && items[1].hook.previous == nullptr);
+    d.insert(d.iterator_to(items[3]), items[1]);
+    d.push_front(items[4]);
+    d.insert(d.end(), items[5]);
+    CHECK(item_values(d) == std::deque<int>({4, 0, 2, 1, 3, 5}) && d.size() == 6);
+    //Крайние элементы вырезаются по ссылке, обход назад от end() видит новый last.
+    d.erase(items[4]);
+    d.erase(items[5]);
+    IntrusiveDeque<Item, &Item::hook>::iterator it = d.end();
+    --it;
+    CHECK(&*it == &items[3] && &d.front() == &items[0]);
+    CHECK(d.erase(d.iterator_to(items[2]))->value == 1 && item_values(d) == std::deque<int>({0, 1, 3}));
+
+    //Один объект сразу в двух деках через два крючка: изменения одного не трогают другой.
+    IntrusiveDeque<Item, &Item::second_hook> other;
+    for(int i = 5; i >= 0; i--) other.push_back(items[i]);
+    d.pop_front();
+    other.erase(items[3]);
+    CHECK(item_values(d) == std::deque<int>({1, 3}) && item_values(other) == std::deque<int>({5, 4, 2, 1, 0}));
+
+    //Перемещение и swap забирают цепочку целиком, объекты не копируются.
+    IntrusiveDeque<Item, &Item::hook> moved(std::move(d));
+    CHECK(d.empty() && moved.size() == 2 && &moved.front() == &items[1]);
+    d.push_back(items[0]);
+    d.swap(moved);
+    CHECK(item_values(d) == std::deque<int>({1, 3}) && item_values(moved) == std::deque<int>({0}));
+    d.clear();
+    moved.clear();
+    other.clear();
+    bool unlinked = true;
+    for(Item& item : items) unlinked = unlinked && item.hook.next == nullptr && item.hook.previous == nullptr &&
+                                       item.second_hook.next == nullptr && item.second_hook.previous == nullptr;
+    CHECK(unlinked && d.empty());
+}
+
+void test_window_aggregator(){
+    WindowAggregator<int> sum;
+    WindowAggregator<int, WindowMax<int>> max;
+    for(int i = 0; i < 10; i++){
+        sum.push(i);
+        max.push(i % 4);
+    }
+    sum.evict();
+    max.evict();
+    CHECK(sum.query() == 45 && max.query() == 3);
+
+    //Окно меняющейся длины против пересчета по всему окну: сумма, минимум, максимум и конкатенация строк,
+    //для которой важен порядок операндов.
+    WindowAggregator<long long> sums;
+    WindowAggregator<int, WindowMin<int>> mins;
+    WindowAggregator<int, WindowMax<int>> maxes;
+    int calls = 0;
+    auto concat = [&calls](const std::string& a, const std::string& b){
+        calls++;
+        return a + b;
+    };
+    WindowAggregator<std::string, decltype(concat)> text(concat);
+    std::deque<int> window;
+    std::uint32_t state = 23;
+    int pushes = 0, queries = 0;
+    bool same = true;
+    for(int step = 0; step < 5000; step++){
+        state = state * 1103515245u + 12345u;
+        //Окно то растет, то сжимается до нуля, чтобы перестройка передней части случалась при разной длине.
+        bool grow = window.empty() || (state >> 16) % 100 < (step / 500 % 2 == 0 ? 60u : 40u);
+        if(grow){
+            int value = static_cast<int>((state >> 8) % 1000) - 500;
+            sums.push(value);
+            mins.push(value);
+            maxes.push(value);
+            text.push(std::string(1, static_cast<char>('a' + (value + 500) % 26)));
+            window.push_back(value);
+            pushes++;
+        }
+        else{
+            sums.evict();
+            mins.evict();
+            maxes.evict();
+            text.evict();
+            window.pop_front();
+        }
+        if(window.empty()){
+            same = same && sums.empty() && mins.empty() && text.empty();
+            continue;
+        }
+        long long total = 0;
+        std::string expected;
+        for(int value : window){
+            total += value;
+            expected += static_cast<char>('a' + (value + 500) % 26);
+        }
+        same = same && sums.query() == total && mins.query() == *std::min_element(window.begin(), window.end()) &&
+               maxes.query() == *std::max_element(window.begin(), window.end()) && text.query() == expected &&
+               mins.size() == window.size();
+        queries++;
+    }
+    CHECK(same);
+    //Не больше трех вызовов Op на элемент плюс один на запрос.
+    CHECK(calls <= 3 * pushes + queries);
+}
+
+void test_min_max_priority_deque(){
+    Deque<int> source;
+    for(int i : {5, 1, 9, 3, 7}) source.push_back(i);
+    MinMaxPriorityDeque<int> h(source);
+    CHECK(h.min() == 1 && h.max() == 9);
+    h.pop_max();
+    h.pop_min();
+    CHECK(h.min() == 3 && h.max() == 7);
+
+    //Один, два и три элемента: у корня нет внуков, максимум - один из детей или сам корень.
+    MinMaxPriorityDeque<int> small;
+    small.push(4);
+    CHECK(small.min() == 4 && small.max() == 4);
+    small.push(2);
+    CHECK(small.min() == 2 && small.max() == 4);
+    small.push(3);
+    small.pop_max();
+    CHECK(small.size() == 2 && small.min() == 2 && small.max() == 3);
+    small.pop_min();
+    small.pop_max();
+    CHECK(small.empty());
+
+    //Случайные вставки по одной и пачками, с повторами, и снятие с обоих концов против std::multiset.
+    MinMaxPriorityDeque<int> heap;
+    std::multiset<int> ref;
+    std::uint32_t state = 31;
+    bool same = true;
+    for(int step = 0; step < 20000; step++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 10;
+        if(op < 4 || ref.empty()){
+            int value = static_cast<int>((state >> 4) % 500);
+            heap.push(value);
+            ref.insert(value);
+        }
+        else if(op == 4){
+            //Пачка то меньше, то больше кучи: вставка по одному и перестройка целиком.
+            std::vector<int> batch((state >> 8) % 2 == 0 || ref.size() > 300 ? 3 : ref.size() + 5);
+            for(int& value : batch) value = static_cast<int>((state = state * 1103515245u + 12345u) >> 16) % 500;
+            heap.push(batch.begin(), batch.end());
+            ref.insert(batch.begin(), batch.end());
+        }
+        else if(op < 7){
+            heap.pop_min();
+            ref.erase(ref.begin());
+        }
+        else{
+            heap.pop_max();
+            ref.erase(std::prev(ref.end()));
+        }
+        if(!ref.empty()) same = same && heap.min() == *ref.begin() && heap.max() == *ref.rbegin();
+        same = same && heap.size() == ref.size();
+    }
+    CHECK(same);
+    std::vector<int> drained;
+    while(!heap.empty()){
+        drained.push_back(heap.min());
+        heap.pop_min();
+    }
+    CHECK(std::is_sorted(drained.begin(), drained.end()) && drained.size() == ref.size());
+
+    //С std::greater роли концов меняются.
+    MinMaxPriorityDeque<int, std::greater<int>> reversed;
+    for(int i : {5, 1, 9, 3, 7}) reversed.push(i);
+    CHECK(reversed.min() == 9 && reversed.max() == 1);
+}
+
+void test_expiring_deque(){
+    using clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+    ExpiringDeque<int> e(seconds(10), seconds(1));
+    auto contents = [&e]{
+        std::vector<int> values;
+        e.for_each([&values](int value){ values.push_back(value); });
+        return values;
+    };
+    //Начало на границе корзины, чтобы номера корзин были 1000 + секунда.
+    clock::time_point base(seconds(1000));
+    for(int i = 0; i < 20; i++) CHECK(e.push(i, base + seconds(i)));
+    //Опоздавшие события: в середину существующей корзины, в существующую и в новую корзину перед всеми.
+    CHECK(e.push(100, base + milliseconds(5500)) && e.push(101, base + seconds(3)) && e.push(102, base - seconds(5)));
+    CHECK(e.size() == 23 && e.bucket_count() == 21);
+
+    //now - ttl = 1005.999 c: корзина 1005 еще не целиком старше ttl, выбрасываются 995 и 1000..1004.
+    CHECK(e.expire(base + milliseconds(15999)) == 7);
+    CHECK(e.size() == 16 && e.bucket_count() == 15);
+    CHECK(e.expire(base + seconds(16)) == 2);
+    CHECK(e.size() == 14 && e.bucket_count() == 14);
+
+    //Ниже горизонта событие отвергается, в первую живую корзину - принимается.
+    CHECK(!e.push(200, base + milliseconds(5999)));
+    CHECK(e.push(201, base + seconds(6)) && e.push(202, base + seconds(30)));
+    CHECK(e.size() == 16 && e.bucket_count() == 15);
+    std::vector<int> expected = {6, 201};
+    for(int i = 7; i < 20; i++) expected.push_back(i);
+    expected.push_back(202);
+    CHECK(contents() == expected);
+
+    //Узлы выброшенных событий переиспользуются push, старые значения не просачиваются.
+    CHECK(e.expire(base + seconds(40)) == 15 && e.size() == 1 && e.bucket_count() == 1);
+    for(int i = 300; i < 320; i++) CHECK(e.push(i, base + seconds(30)));
+    expected = {202};
+    for(int i = 300; i < 320; i++) expected.push_back(i);
+    CHECK(contents() == expected);
+    CHECK(e.expire(base + seconds(41)) == 21 && e.empty() && e.bucket_count() == 0);
+
+    ExpiringDeque<std::string> strings(seconds(1), seconds(1));
+    strings.push("old", base);
+    strings.expire(base + seconds(5));
+    CHECK(strings.push("new", base + seconds(5)) && strings.size() == 1);
+    strings.for_each([](const std::string& value){ CHECK(value == "new"); });
+    strings.clear();
+    CHECK(strings.empty() && strings.push("again", base + seconds(6)));
+}
+
+//Эталон для LruCache: те же сегменты на std::deque ключей, от недавних к давним.
+struct Lru_model {
+    std::size_t capacity;
+    std::size_t protected_capacity;
+    std::deque<int> probation;
+    std::deque<int> protected_segment;
+    std::map<int, int> values;
+
+    void unlink(int key){
+        for(std::deque<int>* segment : {&probation, &protected_segment}){
+            auto it = std::find(segment->begin(), segment->end(), key);
+            if(it != segment->end()) segment->erase(it);
+        }
+    }
+
+    void promote(int key){
+        unlink(key);
+        if(protected_capacity == 0){
+            probation.push_front(key);
+            return;
+        }
+        protected_segment.push_front(key);
+        if(protected_segment.size() > protected_capacity){
+            probation.push_front(protected_segment.back());
+            protected_segment.pop_back();
+        }
+    }
+
+    void put(int key, int value){
+        if(values.count(key)){
+            values[key] = value;
+            promote(key);
+            return;
+        }
+        if(values.size() == capacity){
+            std::deque<int>& victims = probation.empty() ? protected_segment : probation;
+            values.erase(victims.back());
+            victims.pop_back();
+        }
+        values[key] = value;
+        probation.push_front(key);
+    }
+
+    bool erase(int key){
+        if(!values.erase(key)) return false;
+        unlink(key);
+        return true;
+    }
+};
+
+//Хэш с тремя значениями: все ключи ложатся в три цепочки, и удаление сдвигает длинные цепочки назад.
+struct Clashing_hash {
+    std::size_t operator()(int key) const{
+        return static_cast<std::size_t>(key % 3);
+    }
+};
+
+void test_lru_cache(){
+    //Порядок вытеснения: get, touch и put существующего ключа делают запись самой свежей.
+    LruCache<int, int> cache(4);
+    for(int i = 1; i <= 4; i++) cache.put(i, i * 10);
+    CHECK(cache.size() == 4 && cache.capacity() == 4);
+    CHECK(cache.get(1) != nullptr && *cache.get(1) == 10);
+    CHECK(cache.touch(2) && !cache.touch(9));
+    cache.put(3, 33);
+    //От давних к недавним: 4, 1, 2, 3.
+    cache.put(5, 50);
+    CHECK(!cache.contains(4) && cache.contains(1));
+    cache.put(6, 60);
+    CHECK(!cache.contains(1) && cache.contains(2));
+    //contains не освежает запись.
+    CHECK(cache.contains(2));
+    cache.put(7, 70);
+    CHECK(!cache.contains(2) && cache.contains(3) && *cache.get(3) == 33);
+    CHECK(cache.size() == 4);
+
+    //Вытесненный узел переиспользуется новой записью.
+    int* reused = cache.get(5);
+    cache.put(6, 61);
+    cache.put(7, 71);
+    cache.put(3, 34);
+    cache.put(8, 80);
+    CHECK(!cache.contains(5) && cache.get(8) == reused && *reused == 80);
+
+    //erase освобождает место: следующий put ничего не вытесняет.
+    CHECK(cache.erase(6) && !cache.erase(6) && cache.size() == 3);
+    cache.put(9, 90);
+    CHECK(cache.size() == 4 && cache.contains(7) && cache.contains(3) && cache.contains(8) && cache.contains(9));
+
+    //Статистика считает только get и переживает clear.
+    std::size_t hits = cache.hits();
+    std::size_t misses = cache.misses();
+    CHECK(cache.get(6) == nullptr && cache.get(9) != nullptr);
+    CHECK(cache.hits() == hits + 1 && cache.misses() == misses + 1);
+    cache.clear();
+    CHECK(cache.empty() && cache.get(9) == nullptr && cache.misses() == misses + 2);
+    CHECK(cache.hit_rate() == static_cast<double>(cache.hits()) / (cache.hits() + cache.misses()));
+    LruCache<int, int> fresh(1);
+    CHECK(fresh.hit_rate() == 0.0);
+    fresh.put(1, 1);
+    fresh.put(2, 2);
+    CHECK(fresh.size() == 1 && !fresh.contains(1) && *fresh.get(2) == 2 && fresh.hit_rate() == 1.0);
+
+    //SLRU: повторно использованные записи переходят в защищенный сегмент, и проход по новым ключам их не вытесняет.
+    LruCache<int, int> slru(6, 3);
+    for(int i = 1; i <= 6; i++) slru.put(i, i);
+    CHECK(slru.get(1) && slru.get(2) && slru.get(3));
+    for(int i = 100; i < 200; i++) slru.put(i, i);
+    CHECK(slru.contains(1) && slru.contains(2) && slru.contains(3) && !slru.contains(4) && slru.contains(199));
+    //Четвертая горячая запись вытесняет из защищенного сегмента самую давнюю (1) в начало испытательного.
+    CHECK(slru.get(199));
+    CHECK(slru.contains(1));
+    slru.put(200, 200);
+    slru.put(201, 201);
+    CHECK(slru.contains(1) && !slru.contains(198));
+    slru.put(202, 202);
+    slru.put(203, 203);
+    CHECK(!slru.contains(1) && slru.contains(2) && slru.contains(3) && slru.contains(199));
+    //put существующего ключа тоже считается повторным использованием.
+    slru.put(203, 2030);
+    CHECK(*slru.get(203) == 2030 && slru.erase(2) && slru.size() == 5);
+
+    //Случайные операции против эталона, для LRU и для SLRU.
+    for(std::size_t protected_capacity : {0, 5}){
+        LruCache<int, int> lru(12, protected_capacity);
+        Lru_model model{12, protected_capacity, {}, {}, {}};
+        std::uint32_t state = 7;
+        bool same = true;
+        for(int step = 0; step < 20000 && same; step++){
+            state = state * 1103515245u + 12345u;
+            int key = static_cast<int>((state >> 16) % 40);
+            switch((state >> 8) % 5){
+                case 0:
+                case 1:
+                    lru.put(key, step);
+                    model.put(key, step);
+                    break;
+                case 2:{
+                    int* value = lru.get(key);
+                    bool cached = model.values.count(key) != 0;
+                    same = (value != nullptr) == cached && (!cached || *value == model.values[key]);
+                    if(cached) model.promote(key);
+                    break;
+                }
+                case 3:
+                    same = lru.touch(key) == (model.values.count(key) != 0);
+                    if(model.values.count(key)) model.promote(key);
+                    break;
+                default:
+                    same = lru.erase(key) == model.erase(key);
+            }
+            same = same && lru.size() == model.values.size();
+            for(int k = 0; k < 40 && same; k++) same = lru.contains(k) == (model.values.count(k) != 0);
+        }
+        CHECK(same);
+    }
+
+    //Hash_index: вставка не заменяет значение, assign заменяет, erase со сдвигом назад не теряет соседей по цепочке.
+    Hash_index<int, int> index;
+    CHECK(index.empty() && index.find(1) == nullptr && !index.erase(1));
+    CHECK(index.insert(1, 2) && !index.insert(1, 3) && *index.find(1) == 2);
+    index.assign(1, 4);
+    index.assign(2, 5);
+    CHECK(*index.find(1) == 4 && *index.find(2) == 5 && index.size() == 2);
+    index.reserve(1000);
+    CHECK(*index.find(1) == 4 && *index.find(2) == 5);
+    index.clear();
+    CHECK(index.empty() && index.find(1) == nullptr && index.insert(1, 6));
+
+    Hash_index<int, int, Clashing_hash> clashing;
+    std::map<int, int> ref;
+    std::uint32_t state = 11;
+    bool same = true;
+    for(int step = 0; step < 20000 && same; step++){
+        state = state * 1103515245u + 12345u;
+        int key = static_cast<int>((state >> 16) % 60);
+        if((state >> 8) % 3 == 0){
+            same = clashing.erase(key) == (ref.erase(key) != 0);
+        }
+        else{
+            same = clashing.insert(key, step) == ref.emplace(key, step).second;
+        }
+        same = same && clashing.size() == ref.size();
+        for(int k = 0; k < 60 && same; k++){
+            const int* found = clashing.find(k);
+            auto it = ref.find(k);
+            same = it == ref.end() ? found == nullptr : found != nullptr && *found == it->second;
+        }
+    }
+    CHECK(same);
+}
+
+struct Keyed {
+    int id;
+    int payload;
+};
+
+struct Key_of {
+    int operator()(const Keyed& k) const{
+        return k.id;
+    }
+};
+
+void test_indexed_deque(){
+    IndexedDeque<Keyed, Key_of> d;
+    CHECK(d.push_back({1, 10}) && d.push_back({2, 20}) && !d.push_front({1, 30}));
+    CHECK(d.contains(2) && d.find(1).cur != nullptr);
+    CHECK(d.erase_key(1) && d.size() == 1);
+
+    //Ключом может быть и поле: KeyFn вызывается через std::invoke.
+    IndexedDeque<Keyed, int Keyed::*> by_payload(&Keyed::payload);
+    CHECK(by_payload.push_back({1, 10}) && by_payload.push_back({2, 20}) && !by_payload.push_back({3, 10}));
+    CHECK(by_payload.contains(20) && !by_payload.contains(2));
+
+    //Ненайденный ключ дает end() самого дека: от него можно шагнуть назад к последнему элементу.
+    Deque<Keyed>::const_iterator missing = d.find(7);
+    CHECK(missing == d.items().end());
+    --missing;
+    CHECK(missing->id == 2);
+
+    //Индекс следует за всеми изменениями: вставки с обоих концов и в середину, pop и erase по ключу.
+    IndexedDeque<Keyed, Key_of> orders;
+    std::deque<int> ref;
+    for(int i = 0; i < 2000; i++){
+        CHECK(i % 2 == 0 ? orders.push_back({i, i}) : orders.push_front({i, i}));
+        if(i % 2 == 0) ref.push_back(i);
+        else ref.push_front(i);
+    }
+    CHECK(orders.insert(orders.find(1000), {5000, 0}) && !orders.insert(orders.find(10), {10, 0}));
+    ref.insert(std::find(ref.begin(), ref.end(), 1000), 5000);
+    for(int i = 0; i < 2000; i += 3){
+        CHECK(orders.erase_key(i) && !orders.erase_key(i));
+        ref.erase(std::find(ref.begin(), ref.end(), i));
+    }
+    orders.pop_front();
+    ref.pop_front();
+    orders.pop_back();
+    ref.pop_back();
+    bool indexed = orders.size() == ref.size();
+    for(int key : ref) indexed = indexed && orders.contains(key) && orders.find(key)->id == key;
+    for(int i = 0; i < 2000; i += 3) indexed = indexed && !orders.contains(i) && orders.find(i) == orders.items().end();
+    CHECK(indexed && orders.front().id == ref.front() && orders.back().id == ref.back());
+    //Удаленный ключ можно добавить снова.
+    CHECK(orders.push_back({0, 1}) && orders.back().id == 0 && orders.find(0) != orders.items().end());
+    orders.clear();
+    CHECK(orders.empty() && !orders.contains(5000) && orders.push_front({5000, 0}));
+}
+
+//Элементы SortedDeque по порядку, проход вперед, и тот же проход назад от end().
+template <class Sorted>
+std::vector<int> sorted_items(const Sorted& s){
+    std::vector<int> items(s.begin(), s.end());
+    std::vector<int> backward;
+    for(auto it = s.end(); it != s.begin();) backward.push_back(*--it);
+    std::reverse(backward.begin(), backward.end());
+    CHECK(backward == items && items.size() == s.size());
+    return items;
+}
+
+struct Tagged_less {
+    bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const{
+        return a.first < b.first;
+    }
+};
+
+void test_sorted_deque(){
+    //Вставка в середину полного блока делит его пополам; после деления позиции и границы остаются верными.
+    SortedDeque<int> s(4);
+    for(int i : {10, 20, 30, 40}) s.insert(i);
+    s.insert(25);
+    s.insert(15);
+    s.insert(35);
+    s.insert(5);
+    s.insert(45);
+    CHECK(sorted_items(s) == std::vector<int>({5, 10, 15, 20, 25, 30, 35, 40, 45}));
+    CHECK(s.front() == 5 && s.back() == 45);
+    CHECK(*s.lower_bound(25) == 25 && *s.upper_bound(25) == 30 && *s.lower_bound(26) == 30);
+    CHECK(s.lower_bound(0) == s.begin() && s.upper_bound(45) == s.end() && s.lower_bound(46) == s.end());
+    CHECK(std::distance(s.begin(), s.lower_bound(31)) == 6);
+
+    //Повторы: equal_range охватывает их все, даже если они лежат в нескольких блоках.
+    for(int i = 0; i < 9; i++) s.insert(20);
+    auto range = s.equal_range(20);
+    CHECK(std::distance(s.begin(), range.first) == 3 && std::distance(range.first, range.second) == 10);
+    CHECK(*range.second == 25 && *--range.first == 15);
+    CHECK(s.contains(20) && !s.contains(21) && !s.contains(4) && !s.contains(46));
+    for(int i = 0; i < 10; i++) CHECK(s.erase(20));
+    CHECK(!s.erase(20) && !s.contains(20) && s.size() == 8);
+
+    //Удаление до опустевших блоков и с обоих концов.
+    s.pop_front();
+    s.pop_back();
+    CHECK(s.front() == 10 && s.back() == 40);
+    s.erase(s.lower_bound(30));
+    CHECK(sorted_items(s) == std::vector<int>({10, 15, 25, 35, 40}));
+    while(!s.empty()) s.pop_back();
+    CHECK(s.begin() == s.end() && s.lower_bound(1) == s.end());
+    s.insert(3);
+    CHECK(s.size() == 1 && s.front() == 3 && s.back() == 3);
+    s.clear();
+    CHECK(s.empty());
+
+    //Равные элементы идут в порядке вставки, в том числе через деления блоков.
+    SortedDeque<std::pair<int, int>, Tagged_less> stable(3);
+    for(int i = 0; i < 60; i++) stable.insert({i % 4, i});
+    bool ordered = true;
+    std::pair<int, int> prev(-1, -1);
+    for(const auto& item : stable){
+        ordered = ordered && (prev.first < item.first || (prev.first == item.first && prev.second < item.second));
+        prev = item;
+    }
+    CHECK(ordered && stable.size() == 60);
+
+    //Обратный порядок через Compare.
+    SortedDeque<int, std::greater<int>> descending(2);
+    for(int i : {1, 5, 3, 4, 2, 5}) descending.insert(i);
+    CHECK(sorted_items(descending) == std::vector<int>({5, 5, 4, 3, 2, 1}));
+    CHECK(*descending.upper_bound(4) == 3 && descending.lower_bound(0) == descending.end());
+
+    //Случайные вставки и удаления против std::multiset на мелких блоках, чтобы деления шли постоянно.
+    for(std::size_t block : {2, 5, 64}){
+        SortedDeque<int> sorted(block);
+        std::multiset<int> ref;
+        std::uint32_t state = 3;
+        bool same = true;
+        for(int step = 0; step < 6000 && same; step++){
+            state = state * 1103515245u + 12345u;
+            int value = static_cast<int>((state >> 16) % 200);
+            std::uint32_t op = (state >> 8) % 8;
+            if(op < 4 || ref.empty()){
+                sorted.insert(value);
+                ref.insert(value);
+            }
+            else if(op == 4){
+                same = sorted.erase(value) == (ref.count(value) != 0);
+                if(ref.count(value)) ref.erase(ref.find(value));
+            }
+            else if(op == 5){
+                sorted.pop_front();
+                ref.erase(ref.begin());
+            }
+            else if(op == 6){
+                sorted.pop_back();
+                ref.erase(std::prev(ref.end()));
+            }
+            else{
+                same = std::distance(sorted.begin(), sorted.lower_bound(value)) ==
+                           std::distance(ref.begin(), ref.lower_bound(value)) &&
+                       std::distance(sorted.begin(), sorted.upper_bound(value)) ==
+                           std::distance(ref.begin(), ref.upper_bound(value));
+            }
+            if(step % 100 == 0) same = same && std::equal(sorted.begin(), sorted.end(), ref.begin(), ref.end());
+        }
+        CHECK(same && sorted.size() == ref.size() && std::equal(sorted.begin(), sorted.end(), ref.begin(), ref.end()));
+    }
+}
+
+void test_log_deque(){
+    //Без курсоров журнал ничего не отбрасывает сам; номера начинаются с first_seq конструктора.
+    LogDeque<int> log(4, 100);
+    for(int i = 0; i < 10; i++) CHECK(log.push_back(i) == 100u + i);
+    CHECK(log.size() == 10 && log.first_seq() == 100 && log.end_seq() == 110);
+    CHECK(log.at_seq(100) == 0 && log.at_seq(103) == 3 && log.at_seq(104) == 4 && log.at_seq(109) == 9);
+    CHECK(log.contains_seq(100) && !log.contains_seq(99) && !log.contains_seq(110));
+    bool threw = false;
+    try{
+        log.at_seq(110);
+    }
+    catch(const std::out_of_range&){
+        threw = true;
+    }
+    CHECK(threw);
+
+    {
+        //Начало отбрасывается до самого отстающего курсора, в том числе посреди блока.
+        LogDeque<int>::Cursor a(log);
+        LogDeque<int>::Cursor b(log, 105);
+        CHECK(a.position() == 100 && b.position() == 105 && log.first_seq() == 100);
+        a.advance(3);
+        CHECK(log.first_seq() == 103 && log.size() == 7 && a.peek() == 3);
+        CHECK(a.next() == 3 && log.first_seq() == 104);
+        //Продвижение курсора, который не в начале, ничего не отбрасывает.
+        CHECK(b.next() == 5 && log.first_seq() == 104);
+        a.advance(100);
+        CHECK(!a.has_next() && a.position() == 110 && a.available() == 0);
+        CHECK(log.first_seq() == 106 && b.available() == 4);
+        {
+            //Новый курсор за пределами журнала ставится на его начало.
+            LogDeque<int>::Cursor late(log, 0);
+            CHECK(late.position() == 106 && late.peek() == 6);
+            late.seek(200);
+            CHECK(late.position() == 110 && log.first_seq() == 106);
+        }
+
+        //truncate сдвигает отстающие курсоры, pop_front - тоже.
+        log.truncate(108);
+        CHECK(log.first_seq() == 108 && b.position() == 108 && a.position() == 110 && b.next() == 8);
+        log.pop_front();
+        CHECK(log.first_seq() == 110 && log.empty() && b.position() == 110 && !b.has_next());
+
+        //Журнал, прочитанный всеми, пуст, но номера продолжаются.
+        CHECK(log.push_back(42) == 110 && log.push_back(43) == 111);
+        CHECK(a.next() == 42 && log.first_seq() == 110);
+        CHECK(b.next() == 42 && log.first_seq() == 111 && log.size() == 1);
+        log.truncate(1000);
+        CHECK(log.empty() && log.first_seq() == 112 && a.position() == 112);
+    }
+    //После снятия курсоров журнал снова хранит все.
+    for(int i = 0; i < 6; i++) log.push_back(i);
+    CHECK(log.size() == 6 && log.first_seq() == 112);
+
+    {
+        //Единственный курсор сразу отпускает все до себя, а уничтожение самого отстающего - до следующего.
+        LogDeque<int>::Cursor fast(log, 114);
+        CHECK(log.first_seq() == 114);
+        {
+            LogDeque<int>::Cursor slow(log, 0);
+            fast.advance(2);
+            CHECK(slow.position() == 114 && log.first_seq() == 114);
+        }
+        CHECK(log.first_seq() == 116 && log.size() == 2 && fast.peek() == 4);
+    }
+
+    //Несколько читателей с разной скоростью на мелких блоках: журнал хранит ровно [самый отстающий, конец),
+    //и каждый элемент доступен по своему номеру.
+    LogDeque<std::uint64_t> stream(3);
+    LogDeque<std::uint64_t>::Cursor c0(stream);
+    LogDeque<std::uint64_t>::Cursor c1(stream);
+    LogDeque<std::uint64_t>::Cursor c2(stream);
+    LogDeque<std::uint64_t>::Cursor* readers[] = {&c0, &c1, &c2};
+    std::uint32_t state = 5;
+    bool consistent = true;
+    for(int step = 0; step < 20000 && consistent; step++){
+        state = state * 1103515245u + 12345u;
+        std::uint32_t op = (state >> 16) % 6;
+        if(op < 3){
+            std::uint64_t seq = stream.end_seq();
+            consistent = stream.push_back(seq * 7) == seq;
+            continue;
+        }
+        LogDeque<std::uint64_t>::Cursor& reader = *readers[op - 3];
+        std::uint64_t count = (state >> 8) % (op == 3 ? 2 : 5);
+        for(std::uint64_t i = 0; i < count && reader.has_next() && consistent; i++){
+            std::uint64_t seq = reader.position();
+            consistent = reader.next() == seq * 7;
+        }
+        std::uint64_t slowest = std::min({c0.position(), c1.position(), c2.position()});
+        consistent = consistent && stream.first_seq() == slowest && stream.size() == stream.end_seq() - slowest;
+        if(!stream.empty()){
+            std::uint64_t seq = slowest + (state >> 4) % stream.size();
+            consistent = consistent && stream.at_seq(seq) == seq * 7 && stream.at_seq(stream.end_seq() - 1) == (stream.end_seq() - 1) * 7;
+        }
+    }
+    CHECK(consistent);
+
+    //Курсор читает элемент на месте, без копии.
+    LogDeque<std::string> lines(2);
+    lines.push_back("alpha");
+    lines.push_back("beta");
+    lines.push_back("gamma");
+    LogDeque<std::string>::Cursor reader(lines);
+    CHECK(&reader.peek() == &lines.at_seq(0) && reader.next() == "alpha" && lines.first_seq() == 1);
+    CHECK(&reader.peek() == &lines.at_seq(1) && reader.peek() == "beta");
+}
+
+constexpr int static_deque_sum(){
+    StaticDeque<int, 4> d;
+    d.push_back(2);
+    d.push_back(3);
+    d.push_front(1);
+    d.pop_back();
+    d.push_back(4);
+    int sum = 0;
+    for(int value : d) sum = sum * 10 + value;
+    return sum;
+}
+
+//Кольцо при компиляции: элемент снимается спереди и кладется назад, начало обходит массив несколько раз.
+constexpr int static_deque_rotation(){
+    StaticDeque<int, 3> d{1, 2, 3};
+    for(int i = 0; i < 10; i++){
+        int value = d.front();
+        d.pop_front();
+        d.push_back(value + 3);
+    }
+    //push_front в пустой дек переносит начало в конец массива.
+    StaticDeque<int, 3> wrapped;
+    wrapped.push_front(9);
+    wrapped.push_back(8);
+    return d.front() * 10000 + d.back() * 100 + wrapped[0] * 10 + wrapped[1] - (d.full() ? 0 : 1);
+}
+
+//Очередь обхода в ширину при компиляции: расстояние от угла до противоположного угла сетки со стенами.
+constexpr int static_deque_grid_distance(){
+    constexpr char grid[4][5] = {"..#.", ".##.", "....", "#.#."};
+    int distance[4][4] = {};
+    for(auto& row : distance){
+        for(int& d : row) d = -1;
+    }
+    StaticDeque<int, 16> queue;
+    queue.push_back(0);
+    distance[0][0] = 0;
+    while(!queue.empty()){
+        int cell = queue.front();
+        queue.pop_front();
+        int r = cell / 4;
+        int c = cell % 4;
+        constexpr int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for(const auto& step : steps){
+            int nr = r + step[0];
+            int nc = c + step[1];
+            if(nr < 0 || nr >= 4 || nc < 0 || nc >= 4 || grid[nr][nc] == '#' || distance[nr][nc] >= 0) continue;
+            distance[nr][nc] = distance[r][c] + 1;
+            queue.push_back(nr * 4 + nc);
+        }
+    }
+    return distance[3][3];
+}
+
+void test_static_deque(){
+    static_assert(static_deque_sum() == 124, "StaticDeque must work in constant expressions");
+    static_assert(static_deque_rotation() == 111398, "the ring must wrap around in constant expressions");
+    static_assert(static_deque_grid_distance() == 6, "StaticDeque must serve as a compile-time queue");
+    constexpr StaticDeque<int, 3> table{7, 8, 9};
+    static_assert(table[1] == 8 && table.back() == 9 && table.full() && table.max_size() == 3, "");
+    static_assert(table.end() - table.begin() == 3 && *table.rbegin() == 9, "");
+
+    //Полный дек отвергает вставку с обоих концов и остается прежним.
+    StaticDeque<int, 2> d{1, 2};
+    int rejected = 0;
+    for(int attempt = 0; attempt < 2; attempt++){
+        try{
+            if(attempt == 0) d.push_back(3);
+            else d.emplace_front(0);
+        }
+        catch(const std::length_error&){
+            rejected++;
+        }
+    }
+    CHECK(rejected == 2 && d.size() == 2 && d.front() == 1 && d.back() == 2);
+    bool threw = false;
+    try{
+        d.at(2);
+    }
+    catch(const std::out_of_range&){
+        threw = true;
+    }
+    CHECK(threw);
+    d.pop_front();
+    d.push_back(3);
+    CHECK(d.full() && d[0] == 2 && d[1] == 3);
+
+    //Равенство и обмен не зависят от того, где в массиве начало кольца.
+    StaticDeque<int, 4> shifted;
+    shifted.push_front(3);
+    shifted.push_front(2);
+    StaticDeque<int, 4> plain{2, 3};
+    CHECK(shifted == plain && shifted != (StaticDeque<int, 4>{2}));
+    plain.push_back(4);
+    shifted.swap(plain);
+    CHECK(shifted.size() == 3 && shifted.back() == 4 && plain.size() == 2 && plain.front() == 2);
+    plain.clear();
+    CHECK(plain.empty() && plain.begin() == plain.end());
+
+    //Случайные операции с обоих концов против std::deque: начало обходит массив много раз.
+    StaticDeque<std::string, 5> ring;
+    std::deque<std::string> ref;
+    std::uint32_t state = 9;
+    bool same = true;
+    for(int step = 0; step < 5000 && same; step++){
+        state = state * 1103515245u + 12345u;
+        std::string value = std::to_string(step);
+        switch((state >> 16) % 4){
+            case 0:
+                if(!ring.full()){
+                    ring.push_back(value);
+                    ref.push_back(value);
+                }
+                break;
+            case 1:
+                if(!ring.full()){
+                    ring.emplace_front(value);
+                    ref.push_front(value);
+                }
+                break;
+            case 2:
+                if(!ring.empty()){
+                    ring.pop_back();
+                    ref.pop_back();
+                }
+                break;
+            default:
+                if(!ring.empty()){
+                    ring.pop_front();
+                    ref.pop_front();
+                }
+        }
+        same = ring.size() == ref.size() && std::equal(ring.begin(), ring.end(), ref.begin(), ref.end()) &&
+               std::equal(ring.rbegin(), ring.rend(), ref.rbegin(), ref.rend());
+    }
+    CHECK(same);
+    StaticDeque<std::string, 5>::const_iterator it = ring.begin();
+    CHECK(it == ring.cbegin() && (ring.empty() || it[ring.size() - 1] == ring.back()));
+}
+
+}  // namespace
+
+int main(){
+    test_deque();
+    test_deque_splice();
+    test_deque_end_iterators();
+    test_deque_make_contiguous();
+    test_deque_compact();
+    test_deque_compacted_nodes_move_between_deques();
+    test_deque_policy();
+    test_deque_save_load();
+    test_deque_load_rejects_bad_header();
+    test_cow_deque();
+    test_persistent_deque();
+    test_mapped_deque();
+    test_spill_deque();
+    test_journaled_deque();
+    test_journaled_deque_recovery();
+    test_journaled_deque_crash_after_snapshot();
+    test_byte_deque();
+    test_shared_deque();
+    test_compressed_deque();
+    test_packed_deque();
+    test_soa_deque();
+    test_record_deque();
+    test_intrusive_deque();
+    test_window_aggregator();
+    test_min_max_priority_deque();
+    test_expiring_deque();
+    test_lru_cache();
+    test_indexed_deque();
+    test_sorted_deque();
+    test_log_deque();
+    test_static_deque();
+    std::string cleanup = "rm -rf " + scratch_dir();
+    if(std::system(cleanup.c_str()) != 0) failures++;
+    if(failures != 0){
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::puts("all tests passed");
+    return 0;
+}